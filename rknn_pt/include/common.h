@@ -1,10 +1,17 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <memory>
 #include <opencv2/core.hpp>
 
 #define OBJ_NUMB_MAX_SIZE 64
 
+// 定义模型类型
+enum ModelType {
+    MODEL_MATERIAL = 0, // 物资识别模型
+    MODEL_DIGIT = 1     // 数字识别模型
+};
+
 typedef struct _BOX_RECT
 {
     int left;
@@ -33,10 +40,29 @@ typedef struct _DetectionBox
 // }DetectionBox;
 
 
+// 只读帧句柄：图像数据由owner持有（如ROS图像消息），从回调到发布全程按引用计数共享，不做深拷贝
+// 持有者只能读取img，需要绘制时先clone
+typedef struct _Frame
+{
+    cv::Mat img;                       // BGR图像视图
+    std::shared_ptr<const void> owner; // 图像数据的所有者，保证img在句柄存活期间有效
+} Frame;
+
+typedef std::shared_ptr<const Frame> FramePtr;
+
+// 创建帧句柄，owner为空时由img自身的引用计数持有数据
+inline FramePtr make_frame(const cv::Mat &img, std::shared_ptr<const void> owner = nullptr)
+{
+    std::shared_ptr<Frame> frame = std::make_shared<Frame>();
+    frame->img = img;
+    frame->owner = owner;
+    return frame;
+}
+
 //这个是绘制红心的函数用到的结构体
 typedef struct _DetectResultsGroup
 {
-    cv::Mat cur_img;
+    FramePtr cur_frame; // 检测所用的帧，与输入共享同一份数据
     int cur_frame_id;
     std::vector<DetectionBox> dets; // 修改为vector
 } DetectResultsGroup;
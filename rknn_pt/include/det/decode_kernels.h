@@ -0,0 +1,68 @@
+#ifndef DECODE_KERNELS_H_
+#define DECODE_KERNELS_H_
+
+#include <stdint.h>
+
+// 解码用的向量化内核：aarch64上使用NEON，x86上使用AVX2（编译时开启-mavx2）或SSE2，其余平台使用标量实现
+
+// 扫描连续n个int8值（n <= 64），返回 >= thres 的位掩码，第k位对应p[k]
+uint64_t scan_ge_mask64(const int8_t *p, int n, int8_t thres);
+
+// 与scan_ge_mask64结果相同的标量实现，用于尾部处理和结果校验
+uint64_t scan_ge_mask64_scalar(const int8_t *p, int n, int8_t thres);
+
+// 对连续n个网格单元（n <= 64）沿类别通道求最大值和对应类别，第k个类别通道位于 cls0 + k * channel_stride
+// 相同最大值保留类别下标较小者，max_out/idx_out 至少各有n个元素
+void argmax_classes_block(const int8_t *cls0, int channel_stride, int num_classes, int n,
+                          int8_t *max_out, uint8_t *idx_out);
+
+// 类别数在编译期确定的版本，类别循环完全展开，已实例化 NC = 10 / 15 / 25
+template <int NC>
+void argmax_classes_block_fixed(const int8_t *cls0, int channel_stride, int n, int8_t *max_out, uint8_t *idx_out);
+
+// 只在class_ids列出的num_ids个类别（按下标升序，num_ids >= 1）中求最大值，idx_out输出实际类别下标
+void argmax_classes_block_subset(const int8_t *cls0, int channel_stride, const uint8_t *class_ids, int num_ids, int n,
+                                 int8_t *max_out, uint8_t *idx_out);
+
+// 与argmax_classes_block结果相同的标量实现
+void argmax_classes_block_scalar(const int8_t *cls0, int channel_stride, int num_classes, int n,
+                                 int8_t *max_out, uint8_t *idx_out);
+
+// 按得分从高到低对候选做基数排序（稳定，得分相同保持原顺序），结果写入order
+// top_k > 0 时只保证前top_k个有序，返回值为order中的有效个数（不超过top_k）
+// keys/key_tmp/order_tmp 为调用方提供的临时缓冲区，各至少n个元素，排序过程不分配内存
+int sort_scores_desc(const float *scores, int n, int top_k, int *order,
+                     uint32_t *keys, uint32_t *key_tmp, int *order_tmp);
+
+// NMS中已保留框的SoA存储，坐标为左上/右下角，面积按 (x2 - x1 + 1) * (y2 - y1 + 1) 计算
+typedef struct _BoxSoA
+{
+    float *x1;
+    float *y1;
+    float *x2;
+    float *y2;
+    float *area;
+    int32_t *cls;
+    int count;
+} BoxSoA;
+
+// 判断候选框是否与kept中任一同类别框的IoU大于thres（IoU按+1像素约定计算），一次比较4（NEON/SSE2）或8（AVX2）个框
+int box_overlaps_any(const BoxSoA *kept, float x1, float y1, float x2, float y2, float area, int32_t cls, float thres);
+
+// 与box_overlaps_any结果相同的标量实现
+int box_overlaps_any_scalar(const BoxSoA *kept, int start, float x1, float y1, float x2, float y2, float area,
+                            int32_t cls, float thres);
+
+// 返回位掩码中最低位1的下标，mask不能为0
+inline int lowest_bit(uint64_t mask)
+{
+    return __builtin_ctzll(mask);
+}
+
+// 返回位掩码中最高位1的下标，mask不能为0
+inline int highest_bit(uint64_t mask)
+{
+    return 63 - __builtin_clzll(mask);
+}
+
+#endif // DECODE_KERNELS_H_
@@ -0,0 +1,48 @@
+#ifndef MODEL_CACHE_H_
+#define MODEL_CACHE_H_
+
+#include <stddef.h>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// mmap映射的模型文件，最后一个视图释放时解除映射
+class MappedModel
+{
+private:
+    void *addr;
+    size_t len;
+
+public:
+    MappedModel(void *addr, size_t len) : addr(addr), len(len) {}
+    ~MappedModel();
+    const unsigned char *data() const { return (const unsigned char *)addr; }
+    size_t size() const { return len; }
+};
+
+// 模型文件的只读视图，持有期间映射有效
+typedef std::shared_ptr<const MappedModel> ModelView;
+
+// 进程内共享的模型文件缓存：同一路径只映射一次，同时初始化的上下文拿到同一份视图；
+// 缓存只保存弱引用，不延长映射的生命周期，初始化完成、视图全部释放后即解除映射并删除条目
+class ModelCache
+{
+private:
+    std::mutex mtx;
+    std::map<std::string, std::weak_ptr<const MappedModel>> models;
+
+    ModelCache() {}
+    void release(const std::string &path); // 最后一个视图释放时删除该路径的条目
+
+public:
+    static ModelCache &instance();
+
+    // 获取模型文件的视图，未映射时映射整个文件；失败返回空
+    ModelView acquire(const std::string &path);
+
+    // 缓存中的条目数（只包含仍有视图的路径）
+    size_t size();
+};
+
+#endif //MODEL_CACHE_H_
@@ -13,27 +13,146 @@
 
 #include "common.h"
 
+namespace dpool
+{
+    class ThreadPool;
+}
+
 #define OBJ_NAME_MAX_SIZE 16
 #define OBJ_NUMB_MAX_SIZE 64
-#define OBJ_CLASS_NUM 25          // 总类别数：15个物资类别 + 10个数字类别
+#define OBJ_CLASS_NUM 25          // 合并标签表的类别数：15个物资类别 + 10个数字类别（解码时的类别数取自模型输出）
 #define NMS_THRESH 0.45           // 非极大值抑制阈值，可以调整
 #define BOX_THRESH 0.65           // 物体检测框置信度阈值，可以调整
+#define COARSE_MARGIN 0.4         // 由粗到细解码的阈值余量，未在实际录制的输出上标定，取偏大的保守值
 #define PROP_BOX_SIZE (5 + OBJ_CLASS_NUM)
+#define OBJ_HEAD_NUM 3            // 检测输出头数量
+#define OBJ_ANCHOR_NUM 3          // 每个输出头的锚点数量
+#define DECODE_MAX_BANDS 8        // 帧内并行解码时最细尺度每个anchor最多切分的行带数
+#define DECODE_MAX_CLASSES 255    // 解码支持的最大类别数：类别下标按uint8_t存放
 
 // 物体和数字识别的类别数量定义
 #define OBJ_MATERIAL_CLASS_NUM 15 // 物资类别数量
 #define OBJ_DIGIT_CLASS_NUM 10    // 数字类别数量
 
+// NMS方式：逐对比较所有已保留框，或只比较空间网格中邻近的已保留框（候选很多时更快，结果相同）
+enum NmsMode
+{
+    NMS_PAIRWISE = 0,
+    NMS_GRID = 1
+};
+
+// 输出张量的内存布局：OUTPUT_NCHW为rknn_outputs_get转换后的默认布局，另外两种为NPU原生布局（免去运行时的布局转换）
+enum OutputFormat
+{
+    OUTPUT_NCHW = 0,   // 同一通道的网格单元连续
+    OUTPUT_NHWC = 1,   // 同一网格单元的通道连续，通道数可能按对齐填充
+    OUTPUT_NC1HWC2 = 2 // 通道按C2分块，块内同一网格单元的C2个通道连续
+};
+
+// 单个输出头的量化查找表，由RkPt根据output_attrs[i].zp/scale和置信度阈值构建一次，逐帧复用
+typedef struct _HeadQuantTable
+{
+    int32_t zp;              // 量化零点
+    float scale;             // 量化尺度
+    int8_t thres_i8;         // 置信度阈值的量化值
+    float conf_threshold;    // 置信度阈值
+    float deq[256];          // 反量化查找表，下标为(uint8_t)q
+    int span;                // 通过阈值的量化值个数，即 128 - thres_i8
+    std::vector<float> score; // 得分表：score[(obj - thres_i8) * span + (cls - thres_i8)] = deq(cls) * deq(obj)
+} HeadQuantTable;
+
+void build_quant_table(HeadQuantTable *table, int32_t zp, float scale, float conf_threshold);
+
+// 解码布局，由RkPt根据output_attrs的维度在init时确定：类别数、各输出头的网格尺寸、步长和锚点
+typedef struct _DecodeLayout
+{
+    int num_classes;                 // 类别数，即 dims[1] / 3 - 5
+    int prop_size;                   // 每个锚点的通道数，即 5 + num_classes
+    int grid_h[OBJ_HEAD_NUM];        // 各输出头的网格高度
+    int grid_w[OBJ_HEAD_NUM];        // 各输出头的网格宽度
+    int stride[OBJ_HEAD_NUM];        // 各输出头的步长，由模型输入尺寸 / 网格尺寸得到
+    const int *anchor[OBJ_HEAD_NUM]; // 各输出头按步长选取的锚点
+    int fmt[OBJ_HEAD_NUM];           // 各输出头的内存布局（OutputFormat）
+    int cell_step[OBJ_HEAD_NUM];     // 相邻网格单元的间隔：NCHW为1，NHWC为每个网格单元的通道数（含对齐），NC1HWC2为C2
+} DecodeLayout;
+
+// 根据三个输出头的NCHW维度（channels, grid_h, grid_w）构建解码布局，维度不符合YOLOv5输出时返回-1
+int build_decode_layout(DecodeLayout *layout, int model_in_h, int model_in_w,
+                        const int *channels, const int *grid_h, const int *grid_w);
+
+// 把一个输出头设置为NPU原生布局解码（fmt为OutputFormat，cell_step含义同DecodeLayout），cell_step与通道数不匹配时返回-1
+int set_head_format(DecodeLayout *layout, int h, int fmt, int cell_step);
+
+// 后处理配置，由RkPt持有，逐帧传给post_process
+typedef struct _PostProcessConfig
+{
+    float nms_threshold;   // NMS阈值
+    int max_candidates;    // NMS前保留的最高得分候选数，<=0不限制
+    int nms_mode;          // NMS方式：NMS_PAIRWISE / NMS_GRID
+    bool coarse_to_fine;   // 由粗到细解码：先扫描粗尺度的box置信度，只在其附近解码最细尺度
+    float coarse_margin;   // 粗尺度活跃判断的阈值余量：box置信度 >= 置信度阈值 - coarse_margin 即视为活跃
+    const uint64_t *cell_masks[OBJ_HEAD_NUM]; // 静态忽略区域：各输出头允许解码的网格单元位图，NULL表示不限制
+    const uint8_t *active_classes; // 参与解码的类别（按下标升序），NULL表示全部类别
+    int num_active_classes;        // active_classes中的类别数
+    dpool::ThreadPool *decode_pool; // 帧内并行解码的共享线程池，NULL表示在推理线程上串行解码
+    int decode_bands;               // 并行解码时最细尺度每个anchor切分的行带数（1 ~ DECODE_MAX_BANDS）
+} PostProcessConfig;
+
+// 静态忽略区域（原图坐标），例如始终入镜的车体和画面下方不会出现目标的区域
+typedef struct _IgnoreRegions
+{
+    std::vector<cv::Rect_<float>> rects;            // 矩形 x, y, w, h
+    std::vector<std::vector<cv::Point2f>> polygons; // 多边形顶点
+} IgnoreRegions;
+
+// 根据忽略区域构建各输出头允许解码的网格单元位图（位为1表示解码），网格单元中心按pads/scale映射回原图坐标判断
+// 返回被忽略的网格单元总数
+int build_ignore_masks(const IgnoreRegions *regions, const DecodeLayout *layout, BOX_RECT pads,
+                       float scale_w, float scale_h, std::vector<uint64_t> *masks);
+
+// 后处理工作区：候选框、排序和NMS所需的全部缓冲区按SoA排列在一块64字节对齐的内存中，
+// 由每个RkPt根据解码布局在init时分配一次，逐帧复用，解码和NMS过程中不再分配内存
+typedef struct _PostProcessWorkspace
+{
+    int capacity;          // 最大候选数：三个输出头的 网格数 * 锚点数 之和
+    float *box_x;          // 候选框左上角x
+    float *box_y;          // 候选框左上角y
+    float *box_w;          // 候选框宽度
+    float *box_h;          // 候选框高度
+    float *score;          // 候选框得分
+    int32_t *cls;          // 候选框类别
+    int *order;            // 按得分排序后的候选下标
+    int *order_tmp;        // 排序临时缓冲区
+    uint32_t *keys;        // 排序键
+    uint32_t *keys_tmp;    // 排序键临时缓冲区
+    float *kept_coords;    // 已保留框和邻近框的坐标、面积（10 * capacity）
+    int32_t *kept_cls;     // 已保留框和邻近框的类别（2 * capacity）
+    int grid_cells;        // 网格NMS的网格数
+    int *cell_head;        // 网格NMS：每个网格的登记链表头
+    int *node_box;         // 网格NMS：链表节点对应的已保留框下标
+    int *node_next;        // 网格NMS：链表下一节点
+    int *seen_by;          // 网格NMS：已保留框最近一次被哪个候选收集
+    int *wide_boxes;       // 网格NMS：覆盖网格过多的已保留大框
+    uint64_t *cell_mask;   // 由粗到细解码：最细尺度需要解码的网格单元位图
+    int cell_mask_words;   // 位图的64位字数，按最大输出头的网格数分配
+    void *mem;             // 整块内存
+} PostProcessWorkspace;
+
+// 根据解码布局和模型输入尺寸分配工作区，失败返回-1
+int init_postprocess_workspace(PostProcessWorkspace *ws, const DecodeLayout *layout, int model_in_h, int model_in_w);
+// 释放工作区
+void release_postprocess_workspace(PostProcessWorkspace *ws);
+
 int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h, int model_in_w,
-                 float conf_threshold, float nms_threshold, BOX_RECT pads, float scale_w, float scale_h,
-                 std::vector<int32_t> &qnt_zps, std::vector<float> &qnt_scales,
+                 const PostProcessConfig *config, BOX_RECT pads, float scale_w, float scale_h,
+                 const DecodeLayout *layout, const HeadQuantTable *tables, PostProcessWorkspace *ws,
                  DetectResultsGroup *group);
 
 void deinitPostProcess();
 
 int draw_image_detect(cv::Mat &cur_img, std::vector<DetectionBox> &results, int cur_frame_id);
 
-void show_draw_results(DetectResultsGroup &results_group);
+void show_draw_results(DetectResultsGroup &results_group, cv::Mat &canvas);
 
 
 #endif //POSTPROCESS_H_
@@ -11,6 +11,15 @@
 
 void letterbox(const cv::Mat &image, cv::Mat &padded_image, BOX_RECT &pads, const float scale, const cv::Size &target_size, const cv::Scalar &pad_color = cv::Scalar(128, 128, 128));
 
-int resize_rga(rga_buffer_t &src, rga_buffer_t &dst, const cv::Mat &image, cv::Mat &resized_image, const cv::Size &target_size);
+// 计算保持宽高比缩放后图像在模型输入中的区域和四周填充，scale_w/scale_h为区域尺寸与原图尺寸之比
+cv::Rect letterbox_rect(const cv::Size &image_size, const cv::Size &target_size, BOX_RECT &pads, float &scale_w, float &scale_h);
+
+// 一次RGA任务完成BGR→RGB和缩放，结果写入dst（RGB，模型输入尺寸）的dst_rect区域，区域外不变；失败返回-1
+// dst_handle非0时dst为已通过importbuffer_fd导入RGA的dma-buf，RGA按句柄直接写入，否则按虚拟地址访问
+int convert_resize_rga(const cv::Mat &image, cv::Mat &dst, const cv::Rect &dst_rect, rga_buffer_handle_t dst_handle = 0);
+
+// CPU完成与convert_resize_rga相同的处理（RGA不可用时的回退路径）；不缩放时与RGA逐字节相同，
+// 缩放时的插值取整与RGA的差异由preprocess-golden-test对照板上捕获的RGA输出检查
+void convert_resize_cpu(const cv::Mat &image, cv::Mat &dst, const cv::Rect &dst_rect);
 
 #endif //PREPROCESS_H_
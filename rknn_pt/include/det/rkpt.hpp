@@ -2,40 +2,100 @@
 #define RKPT_H
 
 #include "rknn_api.h"
+#include "im2d.h"
 
 #include "opencv2/core/core.hpp"
 #include "postprocess.h"
-
-// 定义模型类型
-enum ModelType {
-    MODEL_MATERIAL = 0, // 物资识别模型
-    MODEL_DIGIT = 1     // 数字识别模型
-};
+#include "tensor_memory.h"
 
 static void dump_tensor_attr(rknn_tensor_attr *attr);
-static unsigned char *load_data(FILE *fp, size_t ofst, size_t sz);
-static unsigned char *load_model(const char *filename, int *model_size);
 static int saveFloat(const char *file_name, float *output, int element_size);
 
+#define INFER_SLOTS 2 // 每个上下文的输入槽数：一个在NPU上运行时，另一个预处理下一帧
+
+// 模型输入槽
+typedef struct _InputSlot
+{
+    TensorMemory *mem;              // 输入缓冲区
+    cv::Mat img;                    // mem的视图（RGB，模型输入尺寸），不拥有内存
+    rga_buffer_handle_t rga_handle; // NPU内存导入RGA的句柄，0表示按虚拟地址访问
+    bool canvas_valid;              // letterbox填充色是否已写入
+} InputSlot;
+
+// 推理任务状态
+enum JobState {
+    JOB_QUEUED = 0,  // 已预处理，等待前一个任务取回输出后启动
+    JOB_RUNNING = 1, // NPU运行中
+    JOB_DONE = 2,    // NPU已完成（poll确认过），wait不再等待
+    JOB_FAILED = 3   // 启动或推理出错，wait返回-1
+};
+
+// 已提交的推理任务，按提交顺序完成
+typedef struct _InferJob
+{
+    FramePtr frame;        // 输入帧，结果中共享
+    int frame_id;
+    int slot;              // 使用的输入槽
+    int state;             // JobState
+    BOX_RECT pads;         // 提交时的填充和缩放比例，解码时使用
+    float scale_w, scale_h;
+} InferJob;
+
 class RkPt
 {
 private:
     int ret;
     std::mutex mtx;
     std::string model_path;
-    unsigned char *model_data;
 
     rknn_context ctx;
     rknn_input_output_num io_num;
     rknn_tensor_attr *input_attrs;
     rknn_tensor_attr *output_attrs;
+    rknn_tensor_mem **output_mems; // 原生布局输出绑定的NPU内存
+    rknn_output *outputs;          // NCHW输出，缓冲区init时预分配一次，rknn_outputs_get直接写入，逐帧复用；开启原生输出后释放
+    bool native_output;            // 是否在原生布局上解码，否则通过rknn_outputs_get取NCHW输出
+    bool broken;                   // 输出绑定处于不一致状态（原生输出只绑定了一部分），不再接受任务
     rknn_input inputs[1];
+    InputSlot input_slots[INFER_SLOTS]; // 模型输入缓冲区
+    int bound_slot;                // 当前绑定为模型输入的NPU内存槽，-1表示没有
+    InferJob jobs[INFER_SLOTS];    // 已提交未取回的任务，jobs[0]最早
+    int num_jobs;
+    rknn_run_extend run_ext;       // 非阻塞推理的扩展参数，rknn_wait时使用
 
     int channel, width, height;
     int img_width, img_height;
+    bool use_rga;        // 是否用RGA完成预处理，RGA失败后自动改为CPU
+    bool letterbox_mode; // 是否保持宽高比缩放（四周填充），否则拉伸到模型输入尺寸
+    cv::Rect input_rect; // 缩放后图像在输入缓冲区中的区域，letterbox模式下区域外是预先填好的填充色
+    BOX_RECT input_pads; // 四周填充
+    float input_scale_w, input_scale_h; // 缩放比例（区域尺寸 / 原图尺寸）
+    int geom_img_width, geom_img_height; // 计算上述几何时的图像尺寸
 
-    float nms_threshold, box_conf_threshold;
+    float box_conf_threshold;
+    PostProcessConfig pp_config; // 后处理配置：NMS阈值、候选上限、NMS方式、由粗到细解码、忽略区域位图
+    IgnoreRegions ignore_regions; // 静态忽略区域（原图坐标）
+    std::vector<uint64_t> ignore_masks[OBJ_HEAD_NUM]; // 忽略区域对应的各输出头网格位图，图像尺寸变化时重建
+    int ignore_img_width, ignore_img_height; // 构建位图时的图像尺寸
+    std::vector<uint8_t> active_classes; // 当前任务阶段参与解码的类别，空表示全部类别
     int model_type; // 模型类型：0为物资模型，1为数字模型
+    HeadQuantTable quant_tables[3]; // 三个输出头的量化查找表
+    DecodeLayout decode_layout; // 由输出维度确定的解码布局（类别数、网格、步长、锚点）
+    PostProcessWorkspace pp_workspace; // 后处理工作区，init时按网格尺寸分配一次，逐帧复用
+
+    void build_quant_tables(); // 根据输出量化参数和置信度阈值构建查找表
+    int build_layout(); // 根据输出维度构建解码布局
+    void update_input_geometry(); // 图像尺寸或letterbox设置变化时重新计算缩放和填充，letterbox模式下填充一次画布
+    void set_input_memory(int slot, TensorMemory *mem); // 替换输入槽的缓冲区
+    void release_input_memory(int slot); // 释放输入槽的缓冲区和RGA句柄
+    void preprocess(const cv::Mat &orig_img, InputSlot &slot); // 把帧写入输入槽的图像区域
+    int launch(InferJob &job); // 设置输入并以非阻塞方式启动推理
+    int collect(InferJob &job); // 等待NPU完成并取回输出
+    void decode(const InferJob &job, DetectResultsGroup &result); // 在取回的输出上后处理
+    void launch_queued(); // 启动排队中最早的任务
+    int pick_slot() const; // 选择新任务的输入槽，优先当前绑定的槽
+    int submit_locked(const FramePtr &frame, int frame_id);
+    int wait_locked(DetectResultsGroup &result);
 
 public:
     RkPt(const std::string &model_path);
@@ -43,17 +103,61 @@ public:
     rknn_context *get_pctx();
     // cv::Mat infer(cv::Mat &ori_img);
     // std::vector<detect_result_t> infer(cv::Mat &ori_img);
-    DetectResultsGroup infer(cv::Mat &ori_img, int cur_frame_id);
+    // 阻塞推理：预处理、推理、后处理一次完成，不能与submit/wait混用
+    DetectResultsGroup infer(const FramePtr &frame, int cur_frame_id);
+    
+    // 异步推理：submit预处理并启动推理后立即返回，wait按提交顺序取回结果。NPU运行上一帧时可以提交下一帧，
+    // 下一帧的预处理与NPU并行；wait取回输出后先启动已排队的下一帧再解码，解码也与NPU并行
+    // submit：最多INFER_SLOTS个未取回的任务，已满返回-1
+    int submit(const FramePtr &frame, int frame_id);
+    // poll：最早的任务已完成返回1，仍在运行返回0，没有任务返回-1；最多等待1ms
+    int poll();
+    // wait：阻塞到最早的任务完成并解码，成功返回0，没有任务或推理出错返回-1
+    int wait(DetectResultsGroup &result);
+    // 已提交未取回的任务数
+    int pending() const { return num_jobs; }
     
-    // 设置置信度和NMS阈值
-    void set_thresholds(float conf_thresh, float nms_thresh) {
-        box_conf_threshold = conf_thresh;
-        nms_threshold = nms_thresh;
-    }
+    // 设置置信度和NMS阈值（会重建量化查找表）
+    void set_thresholds(float conf_thresh, float nms_thresh);
     
     // 获取当前设置的阈值
     float get_conf_threshold() const { return box_conf_threshold; }
-    float get_nms_threshold() const { return nms_threshold; }
+    float get_nms_threshold() const { return pp_config.nms_threshold; }
+    
+    // 设置NMS前的候选上限，<=0不限制
+    void set_max_candidates(int max_cand) { pp_config.max_candidates = max_cand; }
+    int get_max_candidates() const { return pp_config.max_candidates; }
+    
+    // 设置NMS方式（NMS_PAIRWISE / NMS_GRID）
+    void set_nms_mode(int mode) { pp_config.nms_mode = mode; }
+    int get_nms_mode() const { return pp_config.nms_mode; }
+    
+    // 设置由粗到细解码：开启后粗尺度box置信度均低于 置信度阈值 - margin 时跳过最细尺度
+    void set_coarse_to_fine(bool enable, float margin) { pp_config.coarse_to_fine = enable; pp_config.coarse_margin = margin; }
+    
+    // 设置帧内并行解码的共享线程池（NULL为串行解码）和最细尺度每个anchor切分的行带数，线程池需比模型活得更久
+    void set_decode_pool(dpool::ThreadPool *pool, int bands) { pp_config.decode_pool = pool; pp_config.decode_bands = bands; }
+    
+    // 开启NPU原生布局（NHWC / NC1HWC2）输出并直接在原生布局上解码，需在init之后调用；失败时保持NCHW输出并返回-1，
+    // 部分输出已绑定后失败时无法恢复NCHW输出，返回-2，之后该上下文的submit/infer都失败
+    int enable_native_output();
+    
+    // 开启零拷贝输入：模型输入用rknn_create_mem分配并绑定，预处理（RGA按fd导入）直接写入，推理时不再拷贝；
+    // 需在init之后调用，失败时保持主机内存输入并返回-1
+    int enable_zero_copy_input();
+    
+    // 设置预处理方式：true为RGA（失败时自动回退CPU），false为CPU
+    void set_rga_preprocess(bool enable) { use_rga = enable; }
+    
+    // 设置是否保持宽高比缩放（letterbox），下一帧重新计算缩放、填充和忽略区域位图
+    void set_letterbox(bool enable);
+    
+    // 设置静态忽略区域（原图坐标），位图在下一帧按图像尺寸重建
+    void set_ignore_regions(const IgnoreRegions &regions);
+    
+    // 设置参与解码的类别（模型内的类别下标），空列表恢复全部类别；下标越界返回-1且不修改
+    int set_active_classes(const std::vector<int> &class_ids);
+    int get_num_classes() const { return decode_layout.num_classes; }
     
     // 设置和获取模型类型
     void set_model_type(int type) { model_type = type; }
@@ -0,0 +1,72 @@
+#ifndef TENSOR_MEMORY_H_
+#define TENSOR_MEMORY_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "rknn_api.h"
+
+// 模型输入张量内存接口：RkPt只通过该接口拿到预处理写入的缓冲区，不关心内存来自哪里
+class TensorMemory
+{
+public:
+    virtual ~TensorMemory() {}
+    virtual void *data() const = 0;       // CPU可访问的地址
+    virtual uint32_t size() const = 0;    // 字节数（含对齐填充）
+    virtual int fd() const = 0;           // dma-buf fd，没有时为-1
+    virtual int offset() const = 0;       // 数据在fd内的偏移
+    virtual int row_stride() const = 0;   // 每行字节数
+    virtual bool bound() const = 0;       // true表示可绑定为模型输入，推理前无需rknn_inputs_set
+    virtual int bind() = 0;               // 把缓冲区设为模型输入（多个缓冲区轮流使用时推理前调用），失败返回-1
+};
+
+// 主机内存实现：普通内存，推理前由rknn_inputs_set拷贝到NPU；不依赖NPU，可在x86上使用
+class HostTensorMemory : public TensorMemory
+{
+private:
+    void *buf;
+    uint32_t buf_size;
+    int stride;
+
+public:
+    HostTensorMemory(int width, int height, int channel)
+    {
+        stride = width * channel;
+        buf_size = (uint32_t)(stride * height);
+        buf = malloc(buf_size);
+    }
+    ~HostTensorMemory() { free(buf); }
+    void *data() const { return buf; }
+    uint32_t size() const { return buf_size; }
+    int fd() const { return -1; }
+    int offset() const { return 0; }
+    int row_stride() const { return stride; }
+    bool bound() const { return false; }
+    int bind() { return 0; }
+};
+
+// NPU内存实现：rknn_create_mem分配一次并通过rknn_set_io_mem绑定为模型输入，预处理直接写入，推理时不再拷贝
+class NpuTensorMemory : public TensorMemory
+{
+private:
+    rknn_context ctx;
+    rknn_tensor_mem *mem;
+    rknn_tensor_attr attr; // 绑定时使用的输入属性
+    int stride;
+
+    NpuTensorMemory(rknn_context ctx, rknn_tensor_mem *mem, const rknn_tensor_attr &attr, int stride)
+        : ctx(ctx), mem(mem), attr(attr), stride(stride) {}
+
+public:
+    // 按输入属性分配并绑定（NHWC、UINT8），失败返回NULL；attr会被改写为绑定时使用的属性
+    static NpuTensorMemory *create(rknn_context ctx, rknn_tensor_attr *attr, int width, int height, int channel);
+    ~NpuTensorMemory();
+    void *data() const { return mem->virt_addr; }
+    uint32_t size() const { return mem->size; }
+    int fd() const { return mem->fd; }
+    int offset() const { return mem->offset; }
+    int row_stride() const { return stride; }
+    bool bound() const { return true; }
+    int bind();
+};
+
+#endif //TENSOR_MEMORY_H_
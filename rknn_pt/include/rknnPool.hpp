@@ -3,27 +3,133 @@
 
 #include "ThreadPool.hpp"
 #include <vector>
+#include <algorithm>
 #include <iostream>
 #include <mutex>
 #include <queue>
+#include <deque>
+#include <map>
+#include <set>
 #include <memory>
+#include <functional>
+#include <chrono>
+#include <condition_variable>
 
+#define CONTEXT_JOBS 2 // 每个上下文最多未取回的任务数：一个在NPU上运行，一个已预处理排队（与RkPt的INFER_SLOTS一致）
+
+// 结果交付方式
+enum DeliveryMode {
+    DELIVER_IN_ORDER = 0, // 严格按帧号顺序交付，不丢帧
+    DELIVER_LATEST = 1    // 只交付最新完成的帧，比它旧的结果直接丢弃
+};
+
+// 在途帧数已满且准入队列已满时的处理策略
+enum AdmissionPolicy {
+    ADMIT_BLOCK = 0,       // 阻塞等待队列有空位
+    ADMIT_DROP_NEWEST = 1, // 丢弃新到的帧
+    ADMIT_DROP_OLDEST = 2  // 丢弃队列中最旧的帧，用新帧替换
+};
+
+// 模型池运行统计
+typedef struct _PoolStats
+{
+    long long submitted;     // 提交给线程池推理的帧数
+    long long delivered;     // 已交付的结果数
+    long long droppedNewest; // 准入阶段丢弃的新帧数
+    long long droppedOldest; // 准入阶段被替换掉的旧帧数
+    long long staleDropped;  // 最新结果优先模式下丢弃的过期结果数
+    int queued;              // 当前在准入队列中等待的帧数
+    int inFlight;            // 当前在途帧数
+} PoolStats;
+
+// 单个模型上下文的运行统计，用于检查各上下文负载是否均衡
+typedef struct _ContextStats
+{
+    long long frames;    // 该上下文处理的帧数
+    double waitMsTotal;  // 累计排队时间（put到submit），毫秒
+    double waitMsMax;    // 最大排队时间，毫秒
+    double inferMsTotal; // 累计推理时间（submit到取回结果，含排在前一帧之后的时间），毫秒
+} ContextStats;
+
+// rknnModel需提供异步推理接口：submit(input, frameId)提交一帧，wait(output)阻塞到最早的任务完成并按提交顺序取回结果，
+// 最多CONTEXT_JOBS个未取回的任务
 //             rknnModel模型类,         模型输入类型              模型输出类型
 template <typename rknnModel, typename inputType, typename outputType>
 class rknnPool
 {
+public:
+    typedef std::function<void(outputType &)> ResultCallback; // 流水线模式下的结果回调
+
 private:
+    typedef std::chrono::steady_clock Clock;
+
+    // 准入队列中等待的帧
+    struct AdmittedFrame
+    {
+        int frameId;             // 帧号
+        inputType input;         // 输入数据
+        Clock::time_point admitted; // 进入模型池的时间
+    };
+
+    // 单个上下文的派发状态，由queueMtx保护
+    struct ContextState
+    {
+        std::deque<AdmittedFrame> inbox; // 已派发给该上下文、尚未submit的帧
+        int outstanding;                 // 已派发未取回的帧数（inbox中的和已submit的），不超过CONTEXT_JOBS
+        bool driving;                    // 该上下文的驱动线程是否仍在运行
+        std::condition_variable inboxCv; // inbox中有新帧或模型池析构时通知驱动线程
+    };
+
+    // 已submit未取回的帧，驱动线程按提交顺序记录
+    struct SubmittedFrame
+    {
+        int frameId;
+        Clock::time_point admitted; // 进入模型池的时间
+        Clock::time_point start;    // submit的时间
+    };
+
     int threadNum; // 线程数量
     std::string modelPath; // 模型路径
 
-    long long id; // 模型ID
-    std::mutex idMtx, queueMtx; // 互斥锁，用于保护id和队列
-    std::unique_ptr<dpool::ThreadPool> pool; // 线程池
-    std::queue<std::future<outputType>> futs; // 存储推理结果的队列
+    std::mutex queueMtx; // 互斥锁，用于保护队列和上下文状态
+    std::unique_ptr<dpool::ThreadPool> pool; // 线程池，每个上下文最多占用一个工作线程
     std::vector<std::shared_ptr<rknnModel>> models; // 模型实例列表
+    std::vector<ContextState> contexts; // 各上下文的派发状态
+    int nextContext;                 // 未取回帧数相同时从这里开始轮流选择上下文
+    std::vector<ContextStats> ctxStats; // 各上下文的运行统计
+
+    // 以帧号为键的完成结构（重排序缓冲区），由queueMtx保护
+    DeliveryMode mode;               // 结果交付方式
+    std::set<int> pending;           // 已提交但尚未完成的帧号
+    std::map<int, std::shared_ptr<outputType>> done; // 已完成但尚未交付的结果
+    bool hasDelivered;               // 是否已交付过结果
+    int lastDelivered;               // 最近一次交付的帧号
+
+    // 有界准入队列：在途帧数已满时新帧在这里等待，不直接进入线程池
+    std::deque<AdmittedFrame> admitQueue; // 等待派发的帧
+    int queueCap;                    // 准入队列容量
+    AdmissionPolicy policy;          // 队列已满时的处理策略
+    PoolStats stats;                 // 运行统计
+
+    // 流水线模式相关
+    bool pipelined;                  // 是否开启流水线模式
+    int depth;                       // 最大在途帧数
+    int inFlight;                    // 当前在途帧数（未完成；流水线模式下还包括已完成未交付）
+    bool delivering;                 // 是否已有线程在交付结果
+    ResultCallback callback;         // 结果回调
+    bool stopping;                   // 析构函数已开始，驱动线程处理完所有帧后退出
+    std::condition_variable slotCv;  // 在途帧数减少时通知
+    std::condition_variable resultCv; // 有新结果完成时通知（阻塞式get使用）
 
 protected:
-    int getModelId(); // 获取模型ID
+    bool canDispatch();              // 是否可以立即派发一帧，需持有queueMtx
+    int pickContext();               // 选择未取回帧数最少的上下文，都已满时返回-1，需持有queueMtx
+    void dispatch(AdmittedFrame &frame); // 把一帧派发给一个上下文，需持有queueMtx
+    void drive(int modelId);         // 驱动线程：submit派发来的帧，按提交顺序阻塞取回结果
+    void finish(int modelId, const SubmittedFrame &frame, std::shared_ptr<outputType> result); // 记录统计后登记结果
+    void release(int n);             // 在途帧数减少n并派发准入队列中等待的帧，需持有queueMtx
+    void complete(int frameId, std::shared_ptr<outputType> result); // 推理完成后登记并交付结果
+    bool popReady(std::shared_ptr<outputType> &result); // 按交付方式取出一个可交付的结果，需持有queueMtx
 
 public:
     rknnPool(const std::string modelPath, int threadNum);// 构造函数，初始化模型路径和线程数量
@@ -32,9 +138,15 @@ public:
     // int put(inputType inputData);
 
     int get(outputType &outputData);                     // 从队列中获取推理结果
+    void set_pipeline(int depth, ResultCallback callback, DeliveryMode mode = DELIVER_IN_ORDER); // 开启流水线模式，结果通过回调交付
+    void set_delivery_mode(DeliveryMode mode);           // 设置结果交付方式
+    void set_admission(int queueCap, AdmissionPolicy policy); // 设置准入队列容量和丢帧策略
+    PoolStats get_stats();                               // 获取运行统计
+    std::vector<ContextStats> get_context_stats();       // 获取各上下文的运行统计
     ~rknnPool();                                         // 析构函数，释放资源
     
     rknnModel* get_model_ptr();                          // 获取模型指针
+    void for_each_model(std::function<void(rknnModel *)> fn); // 对所有上下文的模型执行同一设置
 };
 
 //构造函数：  传入模型路径、线程数
@@ -43,7 +155,18 @@ rknnPool<rknnModel, inputType, outputType>::rknnPool(const std::string modelPath
 {
     this->modelPath = modelPath;
     this->threadNum = threadNum;
-    this->id = 0;
+    this->mode = DELIVER_IN_ORDER;
+    this->hasDelivered = false;
+    this->lastDelivered = 0;
+    this->queueCap = threadNum;
+    this->policy = ADMIT_BLOCK;
+    this->stats = PoolStats();
+    this->pipelined = false;
+    this->depth = threadNum * CONTEXT_JOBS;
+    this->inFlight = 0;
+    this->delivering = false;
+    this->stopping = false;
+    this->nextContext = 0;
 }
 
 //init函数：  初始化模型、线程池
@@ -63,24 +186,54 @@ int rknnPool<rknnModel, inputType, outputType>::init()
     }
 
     // 初始化模型/Initialize the model
-    for (int i = 0, ret = 0; i < threadNum; i++)
+    // 第一个上下文加载模型，其余上下文逐个复制它的权重：rknn_dup_context都读取同一个源上下文，
+    // 运行时没有说明同一上下文上并发复制是安全的，所以同一个模型池内串行复制；不同模型池可以并行初始化
+    int ret = models[0]->init(models[0]->get_pctx(), false);
+    if (ret != 0)
+        return ret;
+    for (int i = 1; i < threadNum; i++)
     {
-        ret = models[i]->init(models[0]->get_pctx(), i != 0);
+        ret = models[i]->init(models[0]->get_pctx(), true);
         if (ret != 0)
             return ret;
     }
 
+    // 所有上下文初始均为空闲，每个上下文启动一个驱动线程，一直运行到模型池析构
+    std::lock_guard<std::mutex> lock(queueMtx);
+    std::vector<ContextState> idle(threadNum);
+    contexts.swap(idle);
+    ctxStats.assign(threadNum, ContextStats());
+    for (int i = 0; i < threadNum; i++)
+    {
+        contexts[i].outstanding = 0;
+        contexts[i].driving = true;
+        pool->submit([this, i]()
+                     { this->drive(i); });
+    }
+
     return 0;
 }
 
-//获取模型id的函数：      利用互斥保护共享资源，并返回模型id
+//是否可以立即派发一帧：在途帧数未达上限且有上下文未满，调用方需持有queueMtx
+template <typename rknnModel, typename inputType, typename outputType>
+bool rknnPool<rknnModel, inputType, outputType>::canDispatch()
+{
+    return inFlight < depth && pickContext() >= 0;
+}
+
+//选择未取回帧数最少的上下文：空闲的上下文优先，其次是只有一帧在推理、可以再排队一帧的上下文；
+//帧数相同时轮流选择，调用方需持有queueMtx
 template <typename rknnModel, typename inputType, typename outputType>
-int rknnPool<rknnModel, inputType, outputType>::getModelId()
+int rknnPool<rknnModel, inputType, outputType>::pickContext()
 {
-    std::lock_guard<std::mutex> lock(idMtx);
-    int modelId = id % threadNum;
-    id++;
-    return modelId;
+    int best = -1;
+    for (int k = 0; k < (int)contexts.size(); k++)
+    {
+        int i = (nextContext + k) % contexts.size();
+        if (contexts[i].outstanding < CONTEXT_JOBS && (best < 0 || contexts[i].outstanding < contexts[best].outstanding))
+            best = i;
+    }
+    return best;
 }
 
 // template <typename rknnModel, typename inputType, typename outputType>
@@ -93,39 +246,338 @@ int rknnPool<rknnModel, inputType, outputType>::getModelId()
 
 
 //放入的函数，利用互斥保护共享资源，并将模型、输入数据、当前帧号作为参数传入
+//帧号在同一个池内必须唯一；没有空闲上下文或在途帧数已满时帧进入有界准入队列，队列也满时按policy阻塞或丢帧
+//返回0表示已接收，1表示该帧被丢弃，-1表示帧号重复
 template <typename rknnModel, typename inputType, typename outputType>
 int rknnPool<rknnModel, inputType, outputType>::put(inputType inputData, int cur_frame_id)
 // int rknnPool<rknnModel, inputType, outputType>::put(inputType inputData)
 {
-    std::lock_guard<std::mutex> lock(queueMtx);//利用互斥保护共享资源
-    //调用infer函数，                                            并将模型、输入数据、当前帧号作为参数传入
-    futs.push(pool->submit(&rknnModel::infer, models[this->getModelId()], inputData, cur_frame_id));
-    // futs.push(pool->submit(&rknnModel::infer, models[this->getModelId()], inputData));
+    std::unique_lock<std::mutex> lock(queueMtx);//利用互斥保护共享资源
+    if (pending.count(cur_frame_id) || done.count(cur_frame_id))
+    {
+        std::cout << "Frame " << cur_frame_id << " is already in the pool" << std::endl;
+        return -1;
+    }
+
+    if (!canDispatch() && (int)admitQueue.size() >= queueCap)
+    {
+        if (policy == ADMIT_DROP_NEWEST || (policy == ADMIT_DROP_OLDEST && admitQueue.empty()))
+        {
+            stats.droppedNewest++;
+            return 1;
+        }
+        if (policy == ADMIT_DROP_OLDEST)
+        {
+            admitQueue.pop_front();
+            stats.droppedOldest++;
+        }
+        else
+            slotCv.wait(lock, [this]()
+                        { return canDispatch() || (int)admitQueue.size() < queueCap; });
+    }
+
+    AdmittedFrame frame = {cur_frame_id, inputData, Clock::now()};
+    if (canDispatch() && admitQueue.empty())
+        dispatch(frame);
+    else
+        admitQueue.push_back(std::move(frame));
 
     return 0;
 }
 
-//取出的函数，利用互斥保护共享资源，并将输出数据作为参数传入
+//把一帧派发给一个上下文，调用方需持有queueMtx且canDispatch()为真
+//帧放入该上下文的inbox，通知它的驱动线程submit
+template <typename rknnModel, typename inputType, typename outputType>
+void rknnPool<rknnModel, inputType, outputType>::dispatch(AdmittedFrame &frame)
+{
+    int modelId = pickContext();
+    nextContext = (modelId + 1) % contexts.size();
+    ContextState &ctx = contexts[modelId];
+    ctx.inbox.push_back(std::move(frame));
+    ctx.outstanding++;
+    pending.insert(ctx.inbox.back().frameId);
+    inFlight++;
+    stats.submitted++;
+    ctx.inboxCv.notify_one();
+}
+
+//驱动线程：每个上下文一个，submit和wait都在这里按顺序调用
+//没有未取回的帧时在inboxCv上休眠，由put/release派发帧时唤醒；先submit所有派发来的帧，其预处理与NPU上的前一帧并行，
+//inbox为空时阻塞在wait上直到最早的帧完成，不轮询。wait期间派发来的帧在wait返回后submit。模型池析构且没有帧时退出
+template <typename rknnModel, typename inputType, typename outputType>
+void rknnPool<rknnModel, inputType, outputType>::drive(int modelId)
+{
+    std::shared_ptr<rknnModel> model = models[modelId];
+    std::deque<SubmittedFrame> running; // 已submit未取回的帧，按提交顺序
+    while (true)
+    {
+        std::deque<AdmittedFrame> batch;
+        {
+            std::unique_lock<std::mutex> lock(queueMtx);
+            ContextState &ctx = contexts[modelId];
+            if (running.empty())
+                ctx.inboxCv.wait(lock, [this, &ctx]()
+                                 { return !ctx.inbox.empty() || stopping; });
+            batch.swap(ctx.inbox);
+            if (batch.empty() && running.empty())
+            {
+                // 持锁通知：析构函数看到所有驱动线程都已退出后即可返回
+                ctx.driving = false;
+                slotCv.notify_all();
+                return;
+            }
+        }
+
+        for (auto &frame : batch)
+        {
+            SubmittedFrame submitted = {frame.frameId, frame.admitted, Clock::now()};
+            int ret = -1;
+            try
+            {
+                ret = model->submit(frame.input, frame.frameId);
+            }
+            catch (const std::exception &e)
+            {
+                std::cout << "Inference submit failed: " << e.what() << std::endl;
+            }
+            if (ret == 0)
+                running.push_back(submitted);
+            else
+                finish(modelId, submitted, nullptr);
+        }
+        if (running.empty())
+            continue;
+
+        std::shared_ptr<outputType> result = std::make_shared<outputType>();
+        int ret = -1;
+        try
+        {
+            ret = model->wait(*result);
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << "Inference failed: " << e.what() << std::endl;
+        }
+        SubmittedFrame frame = running.front();
+        running.pop_front();
+        finish(modelId, frame, ret == 0 ? result : nullptr);
+    }
+}
+
+//一帧取回（或提交失败）后：记录排队和推理时间，上下文空出一个位置并派发准入队列中等待的帧，再登记结果
+template <typename rknnModel, typename inputType, typename outputType>
+void rknnPool<rknnModel, inputType, outputType>::finish(int modelId, const SubmittedFrame &frame,
+                                                        std::shared_ptr<outputType> result)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMtx);
+        ContextStats &cs = ctxStats[modelId];
+        double waitMs = std::chrono::duration<double, std::milli>(frame.start - frame.admitted).count();
+        cs.frames++;
+        cs.waitMsTotal += waitMs;
+        cs.waitMsMax = std::max(cs.waitMsMax, waitMs);
+        cs.inferMsTotal += std::chrono::duration<double, std::milli>(Clock::now() - frame.start).count();
+        contexts[modelId].outstanding--;
+        release(0);
+    }
+    complete(frame.frameId, result);
+}
+
+//在途帧数减少n，并按先后顺序派发准入队列中等待的帧，调用方需持有queueMtx
+template <typename rknnModel, typename inputType, typename outputType>
+void rknnPool<rknnModel, inputType, outputType>::release(int n)
+{
+    inFlight -= n;
+    while (canDispatch() && !admitQueue.empty())
+    {
+        AdmittedFrame front = std::move(admitQueue.front());
+        admitQueue.pop_front();
+        dispatch(front);
+    }
+}
+
+//按交付方式取出一个可交付的结果，调用方需持有queueMtx
+//顺序模式：最小的已完成帧号小于所有未完成帧号时才可交付
+//最新优先模式：直接交付最新完成的帧，更旧的已完成结果丢弃，未完成的旧帧完成后也会被丢弃
+template <typename rknnModel, typename inputType, typename outputType>
+bool rknnPool<rknnModel, inputType, outputType>::popReady(std::shared_ptr<outputType> &result)
+{
+    if (done.empty())
+        return false;
+
+    typename std::map<int, std::shared_ptr<outputType>>::iterator it;
+    if (mode == DELIVER_LATEST)
+    {
+        it = std::prev(done.end());
+        stats.staleDropped += done.size() - 1;
+        if (pipelined)
+            release(done.size() - 1);
+        done.erase(done.begin(), it);
+    }
+    else
+    {
+        it = done.begin();
+        if (!pending.empty() && *pending.begin() < it->first)
+            return false; // 更早的帧还在推理，等待它完成
+    }
+
+    result = it->second;
+    hasDelivered = true;
+    lastDelivered = it->first;
+    done.erase(it);
+    stats.delivered++;
+    if (pipelined)
+        release(1);
+    return true;
+}
+
+//完成函数：登记结果后，由一个线程连续交付所有可交付的结果，其余完成线程直接返回
+template <typename rknnModel, typename inputType, typename outputType>
+void rknnPool<rknnModel, inputType, outputType>::complete(int frameId, std::shared_ptr<outputType> result)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMtx);
+        pending.erase(frameId);
+        if (!result || (mode == DELIVER_LATEST && hasDelivered && frameId <= lastDelivered))
+        {
+            // 推理失败或结果已过期，直接丢弃
+            if (result)
+                stats.staleDropped++;
+            release(1);
+        }
+        else
+        {
+            done[frameId] = result;
+            if (!pipelined) // 阻塞式get模式下结果可能长时间无人取走，完成即释放在途名额
+                release(1);
+        }
+
+        if (!pipelined || delivering) // 阻塞式get由调用方取结果；已有线程在交付时由它顺带交付本帧
+        {
+            resultCv.notify_all();
+            slotCv.notify_all();
+            return;
+        }
+        delivering = true;
+    }
+
+    while (true)
+    {
+        std::shared_ptr<outputType> next;
+        {
+            std::lock_guard<std::mutex> lock(queueMtx);
+            if (!popReady(next))
+            {
+                // 持锁通知：析构函数在!delivering后即可返回，解锁后再通知可能访问已销毁的条件变量
+                delivering = false;
+                slotCv.notify_all();
+                return;
+            }
+        }
+        slotCv.notify_all();
+        if (!callback)
+            continue;
+        try
+        {
+            callback(*next);
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << "Result callback failed: " << e.what() << std::endl;
+        }
+    }
+}
+
+//取出的函数，利用互斥保护共享资源，并将输出数据作为参数传入（流水线模式下结果只通过回调交付，这里总是返回1）
+//不再阻塞在最早提交的帧上：按交付方式等待第一个可交付的结果
 template <typename rknnModel, typename inputType, typename outputType>
 int rknnPool<rknnModel, inputType, outputType>::get(outputType &outputData)
 {
-    std::lock_guard<std::mutex> lock(queueMtx);//利用互斥保护共享资源
-    if(futs.empty() == true)
+    std::unique_lock<std::mutex> lock(queueMtx);//利用互斥保护共享资源
+    if (pipelined)
         return 1;
-    outputData = futs.front().get();
-    futs.pop();
+
+    std::shared_ptr<outputType> result;
+    resultCv.wait(lock, [this, &result]()
+                  { return popReady(result) || (pending.empty() && done.empty()); });
+    if (!result)
+        return 1;
+    outputData = *result;
     return 0;
 }
 
-//析构函数，清空队列
+//开启流水线模式：depth为最大在途帧数（<=0时取上下文数 × CONTEXT_JOBS），callback在工作线程中串行调用
+//注意：回调中不能再向同一个池put，否则在途帧数已满时会死锁
+template <typename rknnModel, typename inputType, typename outputType>
+void rknnPool<rknnModel, inputType, outputType>::set_pipeline(int depth, ResultCallback callback, DeliveryMode mode)
+{
+    std::lock_guard<std::mutex> lock(queueMtx);
+    this->depth = depth > 0 ? depth : threadNum * CONTEXT_JOBS;
+    this->callback = callback;
+    this->mode = mode;
+    this->pipelined = true;
+    release(0); // 在途上限可能变大，提交已在队列中等待的帧
+}
+
+//设置结果交付方式
+template <typename rknnModel, typename inputType, typename outputType>
+void rknnPool<rknnModel, inputType, outputType>::set_delivery_mode(DeliveryMode mode)
+{
+    std::lock_guard<std::mutex> lock(queueMtx);
+    this->mode = mode;
+}
+
+//设置准入队列容量和队列已满时的处理策略
+template <typename rknnModel, typename inputType, typename outputType>
+void rknnPool<rknnModel, inputType, outputType>::set_admission(int queueCap, AdmissionPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(queueMtx);
+    this->queueCap = queueCap > 0 ? queueCap : 0;
+    this->policy = policy;
+}
+
+//获取运行统计
+template <typename rknnModel, typename inputType, typename outputType>
+PoolStats rknnPool<rknnModel, inputType, outputType>::get_stats()
+{
+    std::lock_guard<std::mutex> lock(queueMtx);
+    PoolStats current = stats;
+    current.queued = admitQueue.size();
+    current.inFlight = inFlight;
+    return current;
+}
+
+//获取各上下文的运行统计
+template <typename rknnModel, typename inputType, typename outputType>
+std::vector<ContextStats> rknnPool<rknnModel, inputType, outputType>::get_context_stats()
+{
+    std::lock_guard<std::mutex> lock(queueMtx);
+    return ctxStats;
+}
+
+//析构函数，等待所有已提交的帧推理完成并交付完毕，再通知驱动线程退出并等待它们全部退出，最后回收线程池的工作线程，
+//之后不再有线程访问互斥锁和条件变量
 template <typename rknnModel, typename inputType, typename outputType>
 rknnPool<rknnModel, inputType, outputType>::~rknnPool()
 {
-    while (!futs.empty())
     {
-        outputType temp = futs.front().get();
-        futs.pop();
+        std::unique_lock<std::mutex> lock(queueMtx);
+        slotCv.wait(lock, [this]()
+                    { return pending.empty() && admitQueue.empty() && !delivering; });
+        stopping = true;
+        for (ContextState &ctx : contexts)
+            ctx.inboxCv.notify_all();
+        slotCv.wait(lock, [this]()
+                    {
+                        for (const ContextState &ctx : contexts)
+                        {
+                            if (ctx.driving)
+                                return false;
+                        }
+                        return true;
+                    });
     }
+    pool.reset();
 }
 
 // 获取模型指针函数
@@ -136,4 +588,12 @@ rknnModel* rknnPool<rknnModel, inputType, outputType>::get_model_ptr()
     return models[0].get();
 }
 
+// 对所有上下文的模型执行同一设置（阈值、模型类型等需要每个上下文一致）
+template <typename rknnModel, typename inputType, typename outputType>
+void rknnPool<rknnModel, inputType, outputType>::for_each_model(std::function<void(rknnModel *)> fn)
+{
+    for (auto &model : models)
+        fn(model.get());
+}
+
 #endif
@@ -0,0 +1,355 @@
+#include "det/decode_kernels.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// 标量实现：逐个比较
+uint64_t scan_ge_mask64_scalar(const int8_t *p, int n, int8_t thres)
+{
+  uint64_t mask = 0;
+  for (int k = 0; k < n; k++)
+  {
+    if (p[k] >= thres)
+      mask |= (uint64_t)1 << k;
+  }
+  return mask;
+}
+
+#if defined(__aarch64__)
+// NEON没有movemask指令，用每个字节的位权相加得到16位掩码
+static inline uint64_t movemask_u8(uint8x16_t cmp)
+{
+  static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  uint8x16_t bits = vandq_u8(cmp, vld1q_u8(weights));
+  return (uint64_t)vaddv_u8(vget_low_u8(bits)) | ((uint64_t)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+#endif
+
+// 向量实现：一次比较16（NEON/SSE2）或32（AVX2）个值，剩余不足一个向量的部分走标量
+uint64_t scan_ge_mask64(const int8_t *p, int n, int8_t thres)
+{
+  uint64_t mask = 0;
+  int k = 0;
+#if defined(__aarch64__)
+  int8x16_t t = vdupq_n_s8(thres);
+  for (; k + 16 <= n; k += 16)
+  {
+    uint8x16_t ge = vcgeq_s8(vld1q_s8(p + k), t);
+    mask |= movemask_u8(ge) << k;
+  }
+#elif defined(__AVX2__)
+  __m256i t = _mm256_set1_epi8(thres);
+  for (; k + 32 <= n; k += 32)
+  {
+    // v >= t 等价于 !(t > v)
+    __m256i lt = _mm256_cmpgt_epi8(t, _mm256_loadu_si256((const __m256i *)(p + k)));
+    mask |= (uint64_t)(~(uint32_t)_mm256_movemask_epi8(lt)) << k;
+  }
+#elif defined(__SSE2__)
+  __m128i t = _mm_set1_epi8(thres);
+  for (; k + 16 <= n; k += 16)
+  {
+    // v >= t 等价于 !(t > v)
+    __m128i lt = _mm_cmpgt_epi8(t, _mm_loadu_si128((const __m128i *)(p + k)));
+    mask |= (uint64_t)(~_mm_movemask_epi8(lt) & 0xFFFF) << k;
+  }
+#endif
+  if (k < n)
+    mask |= scan_ge_mask64_scalar(p + k, n - k, thres) << k;
+  return mask;
+}
+
+// 标量实现：逐个网格单元逐类别比较，class_ids不为NULL时只比较其中列出的类别
+static void argmax_classes_scalar_impl(const int8_t *cls0, int channel_stride, const uint8_t *class_ids,
+                                       int num_classes, int n, int8_t *max_out, uint8_t *idx_out)
+{
+  for (int c = 0; c < n; c++)
+  {
+    uint8_t best_id = class_ids ? class_ids[0] : 0;
+    int8_t best = cls0[best_id * channel_stride + c];
+    for (int k = 1; k < num_classes; k++)
+    {
+      uint8_t id = class_ids ? class_ids[k] : (uint8_t)k;
+      int8_t prob = cls0[id * channel_stride + c];
+      if (prob > best) // 严格大于，相同最大值保留先出现的类别
+      {
+        best = prob;
+        best_id = id;
+      }
+    }
+    max_out[c] = best;
+    idx_out[c] = best_id;
+  }
+}
+
+void argmax_classes_block_scalar(const int8_t *cls0, int channel_stride, int num_classes, int n,
+                                 int8_t *max_out, uint8_t *idx_out)
+{
+  argmax_classes_scalar_impl(cls0, channel_stride, NULL, num_classes, n, max_out, idx_out);
+}
+
+// 向量实现：每个类别通道读取一段连续网格单元，维护逐单元的最大值和类别下标
+// NC > 0 时类别数为编译期常量，类别循环可完全展开；NC == 0 时使用运行期的num_classes
+// class_ids不为NULL时只比较其中列出的num_classes个类别（按类别下标升序），输出的是实际类别下标
+template <int NC>
+static inline void argmax_classes_impl(const int8_t *cls0, int channel_stride, const uint8_t *class_ids,
+                                       int num_classes, int n, int8_t *max_out, uint8_t *idx_out)
+{
+  if (NC > 0)
+    num_classes = NC;
+  const uint8_t first = class_ids ? class_ids[0] : 0;
+  int c = 0;
+#if defined(__aarch64__)
+  for (; c + 16 <= n; c += 16)
+  {
+    int8x16_t best = vld1q_s8(cls0 + first * channel_stride + c);
+    uint8x16_t best_id = vdupq_n_u8(first);
+    for (int k = 1; k < num_classes; k++)
+    {
+      uint8_t id = class_ids ? class_ids[k] : (uint8_t)k;
+      int8x16_t v = vld1q_s8(cls0 + id * channel_stride + c);
+      uint8x16_t gt = vcgtq_s8(v, best);
+      best_id = vbslq_u8(gt, vdupq_n_u8(id), best_id);
+      best = vmaxq_s8(best, v);
+    }
+    vst1q_s8(max_out + c, best);
+    vst1q_u8(idx_out + c, best_id);
+  }
+#elif defined(__AVX2__)
+  for (; c + 32 <= n; c += 32)
+  {
+    __m256i best = _mm256_loadu_si256((const __m256i *)(cls0 + first * channel_stride + c));
+    __m256i best_id = _mm256_set1_epi8((char)first);
+    for (int k = 1; k < num_classes; k++)
+    {
+      uint8_t id = class_ids ? class_ids[k] : (uint8_t)k;
+      __m256i v = _mm256_loadu_si256((const __m256i *)(cls0 + id * channel_stride + c));
+      __m256i gt = _mm256_cmpgt_epi8(v, best);
+      best_id = _mm256_blendv_epi8(best_id, _mm256_set1_epi8((char)id), gt);
+      best = _mm256_max_epi8(best, v);
+    }
+    _mm256_storeu_si256((__m256i *)(max_out + c), best);
+    _mm256_storeu_si256((__m256i *)(idx_out + c), best_id);
+  }
+#elif defined(__SSE2__)
+  for (; c + 16 <= n; c += 16)
+  {
+    __m128i best = _mm_loadu_si128((const __m128i *)(cls0 + first * channel_stride + c));
+    __m128i best_id = _mm_set1_epi8((char)first);
+    for (int k = 1; k < num_classes; k++)
+    {
+      uint8_t id = class_ids ? class_ids[k] : (uint8_t)k;
+      __m128i v = _mm_loadu_si128((const __m128i *)(cls0 + id * channel_stride + c));
+      __m128i gt = _mm_cmpgt_epi8(v, best);
+      // SSE2没有有符号字节max和blend，用与/非与/或组合选择
+      best_id = _mm_or_si128(_mm_and_si128(gt, _mm_set1_epi8((char)id)), _mm_andnot_si128(gt, best_id));
+      best = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, best));
+    }
+    _mm_storeu_si128((__m128i *)(max_out + c), best);
+    _mm_storeu_si128((__m128i *)(idx_out + c), best_id);
+  }
+#endif
+  if (c < n)
+    argmax_classes_scalar_impl(cls0 + c, channel_stride, class_ids, num_classes, n - c, max_out + c, idx_out + c);
+}
+
+void argmax_classes_block(const int8_t *cls0, int channel_stride, int num_classes, int n,
+                          int8_t *max_out, uint8_t *idx_out)
+{
+  argmax_classes_impl<0>(cls0, channel_stride, NULL, num_classes, n, max_out, idx_out);
+}
+
+void argmax_classes_block_subset(const int8_t *cls0, int channel_stride, const uint8_t *class_ids, int num_ids, int n,
+                                 int8_t *max_out, uint8_t *idx_out)
+{
+  argmax_classes_impl<0>(cls0, channel_stride, class_ids, num_ids, n, max_out, idx_out);
+}
+
+template <int NC>
+void argmax_classes_block_fixed(const int8_t *cls0, int channel_stride, int n, int8_t *max_out, uint8_t *idx_out)
+{
+  argmax_classes_impl<NC>(cls0, channel_stride, NULL, NC, n, max_out, idx_out);
+}
+
+// 数字模型、物资模型和合并模型的类别数
+template void argmax_classes_block_fixed<10>(const int8_t *, int, int, int8_t *, uint8_t *);
+template void argmax_classes_block_fixed<15>(const int8_t *, int, int, int8_t *, uint8_t *);
+template void argmax_classes_block_fixed<25>(const int8_t *, int, int, int8_t *, uint8_t *);
+
+// 把浮点得分映射为无符号键，键越小得分越高：先变换为随浮点值单调递增的位模式，再按位取反
+// 不直接用int8量化值作键：三个输出头的zp/scale各不相同，得分又是两个量化值反量化后的乘积，
+// 量化值的大小顺序与得分顺序不一致；某一字节全部相同时跳过该趟（如得分都落在同一个2的幂区间时的最高字节）
+static inline uint32_t score_key_desc(float score)
+{
+  uint32_t u;
+  memcpy(&u, &score, sizeof(u));
+  u = (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+  return ~u;
+}
+
+// LSD基数排序：每趟8位共4趟，所有键在某一字节上相同时跳过该趟
+// 设置top_k时先按最高字节的直方图只保留可能进入前top_k的桶，丢弃的候选不参与后续排序
+int sort_scores_desc(const float *scores, int n, int top_k, int *order,
+                     uint32_t *keys, uint32_t *key_tmp, int *order_tmp)
+{
+  if (n <= 0)
+    return 0;
+
+  for (int i = 0; i < n; i++)
+  {
+    keys[i] = score_key_desc(scores[i]);
+    order[i] = i;
+  }
+
+  // 部分选择：找到累计个数首次达到top_k的最高字节桶，只保留该桶及之前的候选（保持原顺序）
+  if (top_k > 0 && top_k < n)
+  {
+    int hist[256] = {0};
+    for (int i = 0; i < n; i++)
+      hist[keys[i] >> 24]++;
+    int limit = 0, count = 0;
+    for (; limit < 256; limit++)
+    {
+      count += hist[limit];
+      if (count >= top_k)
+        break;
+    }
+    int kept = 0;
+    for (int i = 0; i < n; i++)
+    {
+      if ((int)(keys[i] >> 24) <= limit)
+      {
+        keys[kept] = keys[i];
+        order[kept] = order[i];
+        kept++;
+      }
+    }
+    n = kept;
+  }
+
+  uint32_t *src_key = keys, *dst_key = key_tmp;
+  int *src_idx = order, *dst_idx = order_tmp;
+  for (int shift = 0; shift < 32; shift += 8)
+  {
+    int hist[256] = {0};
+    for (int i = 0; i < n; i++)
+      hist[(src_key[i] >> shift) & 0xFF]++;
+    // 所有键在该字节上相同，本趟不改变顺序
+    if (hist[(src_key[0] >> shift) & 0xFF] == n)
+      continue;
+
+    int offset = 0;
+    for (int b = 0; b < 256; b++)
+    {
+      int c = hist[b];
+      hist[b] = offset;
+      offset += c;
+    }
+    for (int i = 0; i < n; i++)
+    {
+      int pos = hist[(src_key[i] >> shift) & 0xFF]++;
+      dst_key[pos] = src_key[i];
+      dst_idx[pos] = src_idx[i];
+    }
+    uint32_t *tk = src_key;
+    src_key = dst_key;
+    dst_key = tk;
+    int *ti = src_idx;
+    src_idx = dst_idx;
+    dst_idx = ti;
+  }
+
+  if (src_idx != order)
+    memcpy(order, src_idx, n * sizeof(int));
+  return (top_k > 0 && top_k < n) ? top_k : n;
+}
+
+// 标量实现：从start开始逐个比较同类别的已保留框
+int box_overlaps_any_scalar(const BoxSoA *kept, int start, float x1, float y1, float x2, float y2, float area,
+                            int32_t cls, float thres)
+{
+  for (int k = start; k < kept->count; k++)
+  {
+    if (kept->cls[k] != cls)
+      continue;
+    float w = fmaxf(0.f, fminf(x2, kept->x2[k]) - fmaxf(x1, kept->x1[k]) + 1.0f);
+    float h = fmaxf(0.f, fminf(y2, kept->y2[k]) - fmaxf(y1, kept->y1[k]) + 1.0f);
+    float i = w * h;
+    float u = area + kept->area[k] - i;
+    float iou = u <= 0.f ? 0.f : i / u;
+    if (iou > thres)
+      return 1;
+  }
+  return 0;
+}
+
+// 向量实现：同时计算多个已保留框与候选框的IoU，类别不同的通道不参与判断；
+// 并集不大于0时IoU按0计，与标量实现一致（阈值为负时这样的框同样被抑制）
+int box_overlaps_any(const BoxSoA *kept, float x1, float y1, float x2, float y2, float area, int32_t cls, float thres)
+{
+  int k = 0;
+#if defined(__aarch64__)
+  float32x4_t bx1 = vdupq_n_f32(x1), by1 = vdupq_n_f32(y1), bx2 = vdupq_n_f32(x2), by2 = vdupq_n_f32(y2);
+  float32x4_t barea = vdupq_n_f32(area), one = vdupq_n_f32(1.0f), zero = vdupq_n_f32(0.f), t = vdupq_n_f32(thres);
+  int32x4_t bcls = vdupq_n_s32(cls);
+  for (; k + 4 <= kept->count; k += 4)
+  {
+    float32x4_t w = vmaxq_f32(zero, vaddq_f32(vsubq_f32(vminq_f32(bx2, vld1q_f32(kept->x2 + k)),
+                                                        vmaxq_f32(bx1, vld1q_f32(kept->x1 + k))), one));
+    float32x4_t h = vmaxq_f32(zero, vaddq_f32(vsubq_f32(vminq_f32(by2, vld1q_f32(kept->y2 + k)),
+                                                        vmaxq_f32(by1, vld1q_f32(kept->y1 + k))), one));
+    float32x4_t i = vmulq_f32(w, h);
+    float32x4_t u = vsubq_f32(vaddq_f32(barea, vld1q_f32(kept->area + k)), i);
+    // 并集不大于0的通道IoU记为0，与标量实现相同
+    float32x4_t iou = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vdivq_f32(i, u)), vcgtq_f32(u, zero)));
+    uint32x4_t hit = vandq_u32(vcgtq_f32(iou, t), vceqq_s32(vld1q_s32(kept->cls + k), bcls));
+    if (vmaxvq_u32(hit))
+      return 1;
+  }
+#elif defined(__AVX2__)
+  __m256 bx1 = _mm256_set1_ps(x1), by1 = _mm256_set1_ps(y1), bx2 = _mm256_set1_ps(x2), by2 = _mm256_set1_ps(y2);
+  __m256 barea = _mm256_set1_ps(area), one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps(), t = _mm256_set1_ps(thres);
+  __m256i bcls = _mm256_set1_epi32(cls);
+  for (; k + 8 <= kept->count; k += 8)
+  {
+    __m256 w = _mm256_max_ps(zero, _mm256_add_ps(_mm256_sub_ps(_mm256_min_ps(bx2, _mm256_loadu_ps(kept->x2 + k)),
+                                                               _mm256_max_ps(bx1, _mm256_loadu_ps(kept->x1 + k))), one));
+    __m256 h = _mm256_max_ps(zero, _mm256_add_ps(_mm256_sub_ps(_mm256_min_ps(by2, _mm256_loadu_ps(kept->y2 + k)),
+                                                               _mm256_max_ps(by1, _mm256_loadu_ps(kept->y1 + k))), one));
+    __m256 i = _mm256_mul_ps(w, h);
+    __m256 u = _mm256_sub_ps(_mm256_add_ps(barea, _mm256_loadu_ps(kept->area + k)), i);
+    __m256 iou = _mm256_and_ps(_mm256_div_ps(i, u), _mm256_cmp_ps(u, zero, _CMP_GT_OQ)); // 并集不大于0时IoU记为0
+    __m256 hit = _mm256_cmp_ps(iou, t, _CMP_GT_OQ);
+    __m256i same = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(kept->cls + k)), bcls);
+    if (_mm256_movemask_ps(_mm256_and_ps(hit, _mm256_castsi256_ps(same))))
+      return 1;
+  }
+#elif defined(__SSE2__)
+  __m128 bx1 = _mm_set1_ps(x1), by1 = _mm_set1_ps(y1), bx2 = _mm_set1_ps(x2), by2 = _mm_set1_ps(y2);
+  __m128 barea = _mm_set1_ps(area), one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps(), t = _mm_set1_ps(thres);
+  __m128i bcls = _mm_set1_epi32(cls);
+  for (; k + 4 <= kept->count; k += 4)
+  {
+    __m128 w = _mm_max_ps(zero, _mm_add_ps(_mm_sub_ps(_mm_min_ps(bx2, _mm_loadu_ps(kept->x2 + k)),
+                                                      _mm_max_ps(bx1, _mm_loadu_ps(kept->x1 + k))), one));
+    __m128 h = _mm_max_ps(zero, _mm_add_ps(_mm_sub_ps(_mm_min_ps(by2, _mm_loadu_ps(kept->y2 + k)),
+                                                      _mm_max_ps(by1, _mm_loadu_ps(kept->y1 + k))), one));
+    __m128 i = _mm_mul_ps(w, h);
+    __m128 u = _mm_sub_ps(_mm_add_ps(barea, _mm_loadu_ps(kept->area + k)), i);
+    __m128 iou = _mm_and_ps(_mm_div_ps(i, u), _mm_cmpgt_ps(u, zero)); // 并集不大于0时IoU记为0
+    __m128 hit = _mm_cmpgt_ps(iou, t);
+    __m128i same = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(kept->cls + k)), bcls);
+    if (_mm_movemask_ps(_mm_and_ps(hit, _mm_castsi128_ps(same))))
+      return 1;
+  }
+#endif
+  return box_overlaps_any_scalar(kept, k, x1, y1, x2, y2, area, cls, thres);
+}
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "model_cache.h"
+
+MappedModel::~MappedModel()
+{
+    munmap(addr, len);
+}
+
+ModelCache &ModelCache::instance()
+{
+    static ModelCache cache;
+    return cache;
+}
+
+//映射模型文件：不再把整个文件读到堆上，页面按需从页缓存读入，同一路径的多次获取共用一份映射。
+//映射只读：rknn_init只读取模型数据，参数不是const只是C接口的写法（官方示例在rknn_init返回后即释放模型缓冲区，
+//运行时使用自己的副本）；万一写入会在初始化时直接报段错误，而不是悄悄改动共享的映射
+ModelView ModelCache::acquire(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    // 查找时不插入条目：映射失败的路径不留下空条目，过期的条目由release删除
+    auto found = models.find(path);
+    ModelView view = found != models.end() ? found->second.lock() : ModelView();
+    if (view)
+        return view;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        printf("Open file %s failed.\n", path.c_str());
+        return ModelView();
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        printf("stat model file %s failed.\n", path.c_str());
+        close(fd);
+        return ModelView();
+    }
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // 映射建立后不再需要文件描述符
+    if (addr == MAP_FAILED)
+    {
+        printf("mmap model file %s failed.\n", path.c_str());
+        return ModelView();
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);  // rknn_init顺序读取整个模型
+
+    // 最后一个视图释放时先解除映射，再删除缓存中的条目
+    view = ModelView(new MappedModel(addr, (size_t)st.st_size), [this, path](const MappedModel *model)
+                     {
+                         delete model;
+                         release(path);
+                     });
+    models[path] = view;
+    return view;
+}
+
+//删除过期的条目；同一路径可能已经重新映射，只删除确实没有视图的条目
+void ModelCache::release(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto found = models.find(path);
+    if (found != models.end() && found->second.expired())
+        models.erase(found);
+}
+
+size_t ModelCache::size()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return models.size();
+}
@@ -1,4 +1,6 @@
 #include "det/postprocess.h"
+#include "det/decode_kernels.h"
+#include "ThreadPool.hpp"
 
 #include <math.h>
 #include <stdint.h>
@@ -7,8 +9,8 @@
 #include <string.h>
 #include <sys/time.h>
 #include <iostream>
+#include <future>
 
-#include <set>
 #include <vector>
 
 // 物资类别标签数组（0-14）  
@@ -58,106 +60,154 @@ inline static int clamp(float val, int min, int max) {
 
 
 
-/* 计算两个矩形框的交并比(IoU) （无需修改）*/
-static float CalculateOverlap(float xmin0, float ymin0, float xmax0, float ymax0,
-                               float xmin1, float ymin1, float xmax1, float ymax1) {
-    // 计算交集区域
-    float w = fmax(0.f, fmin(xmax0, xmax1) - fmax(xmin0, xmin1) + 1.0);
-    float h = fmax(0.f, fmin(ymax0, ymax1) - fmax(ymin0, ymin1) + 1.0);
-    float i = w * h;
-    
-    // 计算并集区域
-    float u = (xmax0 - xmin0 + 1.0) * (ymax0 - ymin0 + 1.0) 
-            + (xmax1 - xmin1 + 1.0) * (ymax1 - ymin1 + 1.0) - i;
-    
-    return u <= 0.f ? 0.f : (i / u);
-}
-
-/* 非极大值抑制(NMS)实现 （无需修改）*/
-static int nms(int validCount, std::vector<float> &outputLocations,
-               std::vector<int> classIds, std::vector<int> &order,
-               int filterId, float threshold) {
+/* 单遍按类别非极大值抑制(NMS)：候选已按得分从高到低排列，每个候选只与已保留的同类别框比较，
+   与已保留框IoU均不超过阈值的候选加入保留集，否则在order中标记为-1；
+   已保留框以SoA形式存放在kept中，IoU按向量一次比较多个框 */
+static int nms(int validCount, const PostProcessWorkspace *ws, int *order,
+               float threshold, BoxSoA *kept) {
+    kept->count = 0;
     for (int i = 0; i < validCount; ++i) {
-        // 跳过已抑制或非目标类别的检测框
-        if (order[i] == -1 || classIds[i] != filterId) continue;
-        
-        int n = order[i];  // 当前基准框索引
-        
-        // 与后续检测框比较
-        for (int j = i + 1; j < validCount; ++j) {
-            int m = order[j];
-            // 跳过已抑制或非目标类别的比较框
-            if (m == -1 || classIds[j] != filterId) continue;
-            
-            // 解算两个框的坐标参数
-            float xmin0 = outputLocations[n * 4 + 0];
-            float ymin0 = outputLocations[n * 4 + 1];
-            float xmax0 = xmin0 + outputLocations[n * 4 + 2]; // xmin + width
-            float ymax0 = ymin0 + outputLocations[n * 4 + 3]; // ymin + height
-            
-            float xmin1 = outputLocations[m * 4 + 0];
-            float ymin1 = outputLocations[m * 4 + 1];
-            float xmax1 = xmin1 + outputLocations[m * 4 + 2];
-            float ymax1 = ymin1 + outputLocations[m * 4 + 3];
-            
-            // 计算IoU并执行抑制
-            float iou = CalculateOverlap(xmin0, ymin0, xmax0, ymax0,
-                                        xmin1, ymin1, xmax1, ymax1);
-            if (iou > threshold) {
-                order[j] = -1; // 标记重叠框为抑制状态
-            }
+        int n = order[i];  // 当前候选框索引
+        int cls = ws->cls[n];
+
+        // 解算候选框的坐标参数
+        float xmin = ws->box_x[n];
+        float ymin = ws->box_y[n];
+        float xmax = xmin + ws->box_w[n]; // xmin + width
+        float ymax = ymin + ws->box_h[n]; // ymin + height
+        float area = (xmax - xmin + 1.0f) * (ymax - ymin + 1.0f);
+
+        // 与已保留的同类别框重叠过大则抑制
+        if (box_overlaps_any(kept, xmin, ymin, xmax, ymax, area, cls, threshold)) {
+            order[i] = -1; // 标记重叠框为抑制状态
+            continue;
         }
+
+        int k = kept->count++;
+        kept->x1[k] = xmin;
+        kept->y1[k] = ymin;
+        kept->x2[k] = xmax;
+        kept->y2[k] = ymax;
+        kept->area[k] = area;
+        kept->cls[k] = cls;
     }
-    return 0;
+    return kept->count;
 }
 
-// 函数 quick_sort_indice_inverse 实现了基于快速排序算法的反向索引排序
-static int quick_sort_indice_inverse(std::vector<float> &input, int left, int right, std::vector<int> &indices)
+/* 网格哈希NMS：把已保留框登记到模型输入上的均匀网格中（框的范围向外扩1像素，与+1像素IoU约定一致），
+   候选框只收集与自身范围重叠的网格中的已保留框，再用同一个IoU内核判断，保留结果与nms()完全相同；
+   超出输入范围的坐标夹到边缘网格，两个框范围重叠时夹取后的网格范围必然重叠 */
+#define NMS_GRID_CELL 32     // 网格边长（像素）
+#define NMS_GRID_MAX_CELLS 16 // 覆盖网格数超过该值的大框不逐格登记，放入所有候选都要比较的大框列表
+
+// 计算坐标范围[lo - 1, hi + 1]覆盖的网格下标区间
+static inline void grid_cell_range(float lo, float hi, int cells, int *first, int *last)
+{
+  float f = floorf((lo - 1.0f) / NMS_GRID_CELL);
+  float l = floorf((hi + 1.0f) / NMS_GRID_CELL);
+  *first = f < 0 ? 0 : (f > cells - 1 ? cells - 1 : (int)f);
+  *last = l < 0 ? 0 : (l > cells - 1 ? cells - 1 : (int)l);
+}
+
+static int nms_grid(int validCount, PostProcessWorkspace *ws, int *order,
+                    float threshold, int model_in_h, int model_in_w, BoxSoA *kept, BoxSoA *near)
 {
-  float key; // 当前基准值
-  int key_index; // 当前基准值在 indices 中的索引
-  int low = left; // 指向当前分区的左边界
-  int high = right; // 指向当前分区的右边界
+  int grid_w = (model_in_w + NMS_GRID_CELL - 1) / NMS_GRID_CELL;
+  int grid_h = (model_in_h + NMS_GRID_CELL - 1) / NMS_GRID_CELL;
+  int *cellHead = ws->cell_head;  // 每个网格的登记链表头
+  int *nodeBox = ws->node_box;    // 链表节点对应的已保留框下标
+  int *nodeNext = ws->node_next;  // 链表下一节点
+  int *seenBy = ws->seen_by;      // 已保留框最近一次被哪个候选收集，避免跨网格重复比较
+  int *wideBoxes = ws->wide_boxes; // 覆盖网格过多的已保留大框
+  int nodeCount = 0, wideCount = 0;
+  for (int c = 0; c < grid_w * grid_h; c++)
+    cellHead[c] = -1;
+  for (int k = 0; k < validCount; k++)
+    seenBy[k] = -1;
 
-  // 检查左边界是否小于右边界，确保有待排序的元素
-  if (left < right)
+  kept->count = 0;
+  for (int i = 0; i < validCount; ++i)
   {
-    key_index = indices[left]; // 记录基准值索引
-    key = input[left]; // 记录基准值
+    int n = order[i]; // 当前候选框索引
+    int cls = ws->cls[n];
+
+    float xmin = ws->box_x[n];
+    float ymin = ws->box_y[n];
+    float xmax = xmin + ws->box_w[n];
+    float ymax = ymin + ws->box_h[n];
+    float area = (xmax - xmin + 1.0f) * (ymax - ymin + 1.0f);
+
+    int gx0, gx1, gy0, gy1;
+    grid_cell_range(xmin, xmax, grid_w, &gx0, &gx1);
+    grid_cell_range(ymin, ymax, grid_h, &gy0, &gy1);
 
-    // 开始进行分区操作
-    while (low < high)
+    // 收集大框列表和范围内网格中的同类别已保留框
+    near->count = 0;
+    for (int w = 0; w < wideCount; w++)
     {
-      // 从右侧找到第一个小于等于基准值的元素
-      while (low < high && input[high] <= key)
+      int k = wideBoxes[w];
+      if (kept->cls[k] != cls)
+        continue;
+      seenBy[k] = i;
+      int c = near->count++;
+      near->x1[c] = kept->x1[k];
+      near->y1[c] = kept->y1[k];
+      near->x2[c] = kept->x2[k];
+      near->y2[c] = kept->y2[k];
+      near->area[c] = kept->area[k];
+      near->cls[c] = cls;
+    }
+    for (int gy = gy0; gy <= gy1; gy++)
+    {
+      for (int gx = gx0; gx <= gx1; gx++)
       {
-        high--; // 右指针向左移动
+        for (int node = cellHead[gy * grid_w + gx]; node != -1; node = nodeNext[node])
+        {
+          int k = nodeBox[node];
+          if (seenBy[k] == i || kept->cls[k] != cls)
+            continue;
+          seenBy[k] = i;
+          int c = near->count++;
+          near->x1[c] = kept->x1[k];
+          near->y1[c] = kept->y1[k];
+          near->x2[c] = kept->x2[k];
+          near->y2[c] = kept->y2[k];
+          near->area[c] = kept->area[k];
+          near->cls[c] = cls;
+        }
       }
-      // 将高指针指向的元素移动到低指针的位置
-      input[low] = input[high];
-      indices[low] = indices[high]; // 同样移动索引
+    }
 
-      // 从左侧找到第一个大于等于基准值的元素
-      while (low < high && input[low] >= key)
+    if (box_overlaps_any(near, xmin, ymin, xmax, ymax, area, cls, threshold))
+    {
+      order[i] = -1; // 标记重叠框为抑制状态
+      continue;
+    }
+
+    // 加入保留集并登记到覆盖的网格
+    int k = kept->count++;
+    kept->x1[k] = xmin;
+    kept->y1[k] = ymin;
+    kept->x2[k] = xmax;
+    kept->y2[k] = ymax;
+    kept->area[k] = area;
+    kept->cls[k] = cls;
+    if ((gx1 - gx0 + 1) * (gy1 - gy0 + 1) > NMS_GRID_MAX_CELLS)
+    {
+      wideBoxes[wideCount++] = k;
+      continue;
+    }
+    for (int gy = gy0; gy <= gy1; gy++)
+    {
+      for (int gx = gx0; gx <= gx1; gx++)
       {
-        low++; // 低指针向右移动
+        nodeBox[nodeCount] = k;
+        nodeNext[nodeCount] = cellHead[gy * grid_w + gx];
+        cellHead[gy * grid_w + gx] = nodeCount++;
       }
-      // 将低指针指向的元素移动到高指针的位置
-      input[high] = input[low];
-      indices[high] = indices[low]; // 同样移动索引
     }
-
-    // 将基准值放回当前分区的正确位置
-    input[low] = key;
-    indices[low] = key_index; // 同样更新索引
-
-    // 递归调用对左侧子数组进行排序
-    quick_sort_indice_inverse(input, left, low - 1, indices);
-    // 递归调用对右侧子数组进行排序
-    quick_sort_indice_inverse(input, low + 1, right, indices);
   }
-  // 返回基准值的最终位置
-  return low;
+  return kept->count;
 }
 
 // 将浮点数剪切到指定的范围内
@@ -181,147 +231,769 @@ static float deqnt_affine_to_f32(int8_t qnt, int32_t zp, float scale)
   return ((float)qnt - (float)zp) * scale; // 使用affine反量化公式将8位整数转换回浮点数
 }
 
-// 处理输入数据，提取目标检测框信息
-// 输入：输入数据，锚点数组，网格高度，网格宽度，模型输入高度，模型输入宽度，步长，结果数组，类别数组，置信度阈值，量化参数
-static int process(int8_t *input, int *anchor, int grid_h, int grid_w, int height, int width, int stride,
-                   std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId, float threshold,
-                   int32_t zp, float scale)
+// 构建单个输出头的量化查找表：反量化表覆盖全部256个量化值，得分表只覆盖能通过阈值的量化值
+void build_quant_table(HeadQuantTable *table, int32_t zp, float scale, float conf_threshold)
 {
-  int validCount = 0; // 有效目标计数
-  int grid_len = grid_h * grid_w; // 网格长度（网格总数）
-  int8_t thres_i8 = qnt_f32_to_affine(threshold, zp, scale); // 将阈值转换为量化值
+  table->zp = zp;
+  table->scale = scale;
+  table->conf_threshold = conf_threshold;
+  table->thres_i8 = qnt_f32_to_affine(conf_threshold, zp, scale); // 将阈值转换为量化值
+  for (int q = -128; q <= 127; q++)
+  {
+    table->deq[(uint8_t)q] = deqnt_affine_to_f32((int8_t)q, zp, scale);
+  }
 
-  // 遍历每个anchor
-  for (int a = 0; a < 3; a++)
+  // 目标置信度需 >= thres_i8，类别概率需 > thres_i8，两者都落在 [thres_i8, 127] 内
+  table->span = 128 - table->thres_i8;
+  table->score.resize(table->span * table->span);
+  for (int obj = 0; obj < table->span; obj++)
   {
-    // 遍历每个网格行
-    for (int i = 0; i < grid_h; i++)
+    for (int cls = 0; cls < table->span; cls++)
     {
-      // 遍历每个网格列
-      for (int j = 0; j < grid_w; j++)
+      table->score[obj * table->span + cls] =
+          table->deq[(uint8_t)(cls + table->thres_i8)] * table->deq[(uint8_t)(obj + table->thres_i8)];
+    }
+  }
+}
+
+// 输出头张量的寻址：通道c、网格单元cell的值位于 channel_ptr(c)[cell * cell_step]
+// NCHW下同一通道的网格单元连续；NHWC和NC1HWC2下同一网格单元的通道连续（NC1HWC2只在C2块内连续）
+typedef struct _HeadView
+{
+  int8_t *data;   // 输出头数据
+  int fmt;        // 内存布局（OutputFormat）
+  int grid_len;   // 网格单元数
+  int cell_step;  // 相邻网格单元的间隔
+} HeadView;
+
+static inline HeadView make_head_view(int8_t *data, const DecodeLayout *layout, int h)
+{
+  HeadView v;
+  v.data = data;
+  v.fmt = layout->fmt[h];
+  v.grid_len = layout->grid_h[h] * layout->grid_w[h];
+  v.cell_step = layout->cell_step[h];
+  return v;
+}
+
+// 通道c在网格单元0处的地址
+static inline int8_t *channel_ptr(const HeadView &v, int c)
+{
+  if (v.fmt == OUTPUT_NC1HWC2)
+    return v.data + (size_t)(c / v.cell_step) * v.grid_len * v.cell_step + c % v.cell_step;
+  if (v.fmt == OUTPUT_NHWC)
+    return v.data + c;
+  return v.data + (size_t)c * v.grid_len;
+}
+
+// 取通道c上[base, base + n)网格单元的值：NCHW下直接返回地址，原生布局下按间隔收集到buf
+static inline const int8_t *load_cells(const HeadView &v, int c, int base, int n, int8_t *buf)
+{
+  const int8_t *p = channel_ptr(v, c) + (size_t)base * v.cell_step;
+  if (v.cell_step == 1)
+    return p;
+  for (int k = 0; k < n; k++)
+    buf[k] = p[(size_t)k * v.cell_step];
+  return buf;
+}
+
+// 取网格单元cell上[c, c + n)通道的值：通道连续时直接返回地址，NC1HWC2跨C2块时收集到buf
+static inline const int8_t *load_channels(const HeadView &v, int c, int cell, int n, int8_t *buf)
+{
+  if (v.fmt == OUTPUT_NHWC || (v.fmt == OUTPUT_NC1HWC2 && c % v.cell_step + n <= v.cell_step))
+    return channel_ptr(v, c) + (size_t)cell * v.cell_step;
+  for (int k = 0; k < n; k++)
+    buf[k] = channel_ptr(v, c + k)[(size_t)cell * v.cell_step];
+  return buf;
+}
+
+// 把一个通过阈值的候选写入工作区：查表反量化box参数，按网格坐标、步长和锚点还原为模型输入上的左上角坐标和宽高
+static inline void write_candidate(PostProcessWorkspace *ws, int c, const HeadQuantTable &table,
+                                   int8_t qx, int8_t qy, int8_t qw, int8_t qh, int i, int j, int stride,
+                                   const int *anchor, int a, int8_t box_confidence, int8_t maxClassProbs, int maxClassId)
+{
+  const float *deq = table.deq; // 反量化查找表
+  int8_t thres_i8 = table.thres_i8;
+  // 查表反量化获取box的中心x坐标，并调整为实际坐标
+  float box_x = deq[(uint8_t)qx] * 2.0 - 0.5;
+  // 查表反量化获取box的中心y坐标，并调整为实际坐标
+  float box_y = deq[(uint8_t)qy] * 2.0 - 0.5;
+  // 查表反量化获取box的宽度，并调整为实际宽度
+  float box_w = deq[(uint8_t)qw] * 2.0;
+  // 查表反量化获取box的高度，并调整为实际高度
+  float box_h = deq[(uint8_t)qh] * 2.0;
+
+  // 根据网格坐标和stride调整box的中心坐标
+  box_x = (box_x + j) * (float)stride;
+  box_y = (box_y + i) * (float)stride;
+  // 使用anchor调整box的宽度和高度
+  box_w = box_w * box_w * (float)anchor[a * 2];
+  box_h = box_h * box_h * (float)anchor[a * 2 + 1];
+  // 调整box的中心坐标到box的左上角坐标
+  box_x -= (box_w / 2.0);
+  box_y -= (box_h / 2.0);
+
+  // 写入工作区：查得分表得到box置信度与最大类概率的乘积，以及最大类ID和box的左上角坐标、宽度和高度
+  ws->score[c] = table.score[(box_confidence - thres_i8) * table.span + (maxClassProbs - thres_i8)];
+  ws->cls[c] = maxClassId;
+  ws->box_x[c] = box_x;
+  ws->box_y[c] = box_y;
+  ws->box_w[c] = box_w;
+  ws->box_h[c] = box_h;
+}
+
+// 按类别数特化的解码器：NC > 0 时类别数为编译期常量，类别循环完全展开；NC == 0 为运行期类别数的通用版本
+template <int NC>
+struct Decoder
+{
+  // 对块内连续网格单元沿类别通道求最大类概率
+  static void argmax(const int8_t *cls0, int grid_len, int num_classes, int n, int8_t *max_out, uint8_t *idx_out)
+  {
+    argmax_classes_block_fixed<NC>(cls0, grid_len, n, max_out, idx_out);
+  }
+
+  // 对单个网格单元连续存放的类别概率求最大值及其类别ID（相同时取下标较小的类别），active_classes非NULL时只比较其中的类别
+  static inline int8_t argmax_cell(const int8_t *cls, int num_classes, const uint8_t *active_classes, int num_active,
+                                   int *class_id)
+  {
+    if (NC > 0)
+      num_classes = NC;
+    int8_t best;
+    int id;
+    if (active_classes)
+    {
+      id = active_classes[0];
+      best = cls[id];
+      for (int k = 1; k < num_active; k++)
       {
-        // 获取当前网格单元的box置信度
-        int8_t box_confidence = input[(PROP_BOX_SIZE * a + 4) * grid_len + i * grid_w + j];
-        // 如果box置信度大于阈值，则进一步处理
-        if (box_confidence >= thres_i8)
+        int c = active_classes[k];
+        if (cls[c] > best)
         {
-          // 计算当前网格单元的偏移量
-          int offset = (PROP_BOX_SIZE * a) * grid_len + i * grid_w + j;
-          int8_t *in_ptr = input + offset; // 指向当前网格单元的指针
-
-          // 反量化获取box的中心x坐标，并调整为实际坐标
-          float box_x = (deqnt_affine_to_f32(*in_ptr, zp, scale)) * 2.0 - 0.5;
-          // 反量化获取box的中心y坐标，并调整为实际坐标
-          float box_y = (deqnt_affine_to_f32(in_ptr[grid_len], zp, scale)) * 2.0 - 0.5;
-          // 反量化获取box的宽度，并调整为实际宽度
-          float box_w = (deqnt_affine_to_f32(in_ptr[2 * grid_len], zp, scale)) * 2.0;
-          // 反量化获取box的高度，并调整为实际高度
-          float box_h = (deqnt_affine_to_f32(in_ptr[3 * grid_len], zp, scale)) * 2.0;
-
-          // 根据网格坐标和stride调整box的中心坐标
-          box_x = (box_x + j) * (float)stride;
-          box_y = (box_y + i) * (float)stride;
-          // 使用anchor调整box的宽度和高度
-          box_w = box_w * box_w * (float)anchor[a * 2];
-          box_h = box_h * box_h * (float)anchor[a * 2 + 1];
-          // 调整box的中心坐标到box的左上角坐标
-          box_x -= (box_w / 2.0);
-          box_y -= (box_h / 2.0);
-
-          // 获取当前网格单元的最大类概率
-          int8_t maxClassProbs = in_ptr[5 * grid_len];
-          int maxClassId = 0; // 初始化最大类ID为0
-          // 遍历每个类的概率，找到最大类概率及其对应的类ID
-          for (int k = 1; k < OBJ_CLASS_NUM; ++k)
-          {
-            int8_t prob = in_ptr[(5 + k) * grid_len];
-            if (prob > maxClassProbs) // 如果当前类的概率大于最大类概率
-            {
-              maxClassId = k; // 更新最大类ID
-              maxClassProbs = prob; // 更新最大类概率
-            }
-          }
-          // 如果最大类概率大于阈值，则将box信息添加到结果中
-          if (maxClassProbs > thres_i8)
-          {
-            // 反量化box置信度和最大类概率，并将两者相乘后添加到objProbs向量中
-            objProbs.push_back((deqnt_affine_to_f32(maxClassProbs, zp, scale)) * (deqnt_affine_to_f32(box_confidence, zp, scale)));
-            // 将最大类ID添加到classId向量中
-            classId.push_back(maxClassId);
-            // 增加有效目标计数
-            validCount++;
-            // 将box的左上角坐标、宽度和高度添加到boxes向量中
-            boxes.push_back(box_x);
-            boxes.push_back(box_y);
-            boxes.push_back(box_w);
-            boxes.push_back(box_h);
-          }
+          best = cls[c];
+          id = c;
         }
       }
     }
+    else
+    {
+      id = 0;
+      best = cls[0];
+      for (int c = 1; c < num_classes; c++)
+      {
+        if (cls[c] > best)
+        {
+          best = cls[c];
+          id = c;
+        }
+      }
+    }
+    *class_id = id;
+    return best;
+  }
+
+  static int process(int8_t *input, const DecodeLayout *layout, int h,
+                     int a_begin, int a_end, int cell_begin, int cell_end,
+                     PostProcessWorkspace *ws, int offset, const HeadQuantTable &table, const uint64_t *cell_mask,
+                     const uint8_t *active_classes, int num_active);
+
+  static int process_native(int8_t *input, const DecodeLayout *layout, int h,
+                            int a_begin, int a_end, int cell_begin, int cell_end,
+                            PostProcessWorkspace *ws, int offset, const HeadQuantTable &table, const uint64_t *cell_mask,
+                            const uint8_t *active_classes, int num_active);
+};
+
+template <>
+void Decoder<0>::argmax(const int8_t *cls0, int grid_len, int num_classes, int n, int8_t *max_out, uint8_t *idx_out)
+{
+  argmax_classes_block(cls0, grid_len, num_classes, n, max_out, idx_out);
+}
+
+// 处理NCHW输出，提取目标检测框信息
+// 输入：输入数据，解码布局及输出头下标，解码的anchor范围[a_begin, a_end)和网格单元范围[cell_begin, cell_end)
+//       （cell_begin按64对齐），工作区及候选的写入起点，量化查找表，
+//       需要解码的网格单元位图（NULL表示全部解码），参与argmax的类别列表（NULL表示全部类别）
+// 阈值判断全部在int8域完成，box置信度和类别概率均按块向量处理，只有通过阈值的候选才查表反量化
+template <int NC>
+int Decoder<NC>::process(int8_t *input, const DecodeLayout *layout, int h,
+                         int a_begin, int a_end, int cell_begin, int cell_end, PostProcessWorkspace *ws,
+                         int offset, const HeadQuantTable &table, const uint64_t *cell_mask,
+                         const uint8_t *active_classes, int num_active)
+{
+  int num_classes = NC > 0 ? NC : layout->num_classes;
+  const int prop_size = 5 + num_classes; // 每个锚点的通道数
+  const int *anchor = layout->anchor[h];
+  int grid_w = layout->grid_w[h], stride = layout->stride[h];
+  int validCount = 0; // 有效目标计数
+  int grid_len = layout->grid_h[h] * grid_w; // 网格长度（网格总数）
+  int8_t thres_i8 = table.thres_i8; // 阈值的量化值
+  int8_t block_max[64];   // 块内各网格单元的最大类概率
+  uint8_t block_idx[64];  // 块内各网格单元的最大类ID
+
+  // 遍历每个anchor
+  for (int a = a_begin; a < a_end; a++)
+  {
+    // 当前anchor的box置信度通道在内存中连续，按64个网格单元一块做向量比较
+    const int8_t *obj_ptr = input + (prop_size * a + 4) * grid_len;
+    for (int base = cell_begin; base < cell_end; base += 64)
+    {
+      int n = cell_end - base < 64 ? cell_end - base : 64;
+      uint64_t mask = scan_ge_mask64(obj_ptr + base, n, thres_i8); // box置信度 >= 阈值的网格单元
+      if (cell_mask)
+        mask &= cell_mask[base >> 6]; // 只保留位图中需要解码的网格单元
+      if (!mask)
+        continue;
+
+      // 对块内第一个到最后一个候选之间的网格单元，按类别通道连续读取求最大类概率
+      int first = lowest_bit(mask);
+      int last = highest_bit(mask);
+      const int8_t *cls_ptr = input + (prop_size * a + 5) * grid_len + base + first;
+      if (active_classes)
+        argmax_classes_block_subset(cls_ptr, grid_len, active_classes, num_active, last - first + 1, block_max, block_idx);
+      else
+        argmax(cls_ptr, grid_len, num_classes, last - first + 1, block_max, block_idx);
+
+      // 按位由低到高遍历，保持与逐行逐列扫描相同的候选顺序
+      while (mask)
+      {
+        int bit = lowest_bit(mask);
+        mask &= mask - 1;
+        int cell = base + bit;
+
+        // 当前网格单元的最大类概率及其对应的类ID，不超过阈值的不做任何浮点计算
+        int8_t maxClassProbs = block_max[bit - first];
+        if (maxClassProbs <= thres_i8)
+          continue;
+
+        // 指向当前网格单元box参数的指针
+        int8_t *in_ptr = input + (prop_size * a) * grid_len + cell;
+        write_candidate(ws, offset + validCount, table, in_ptr[0], in_ptr[grid_len], in_ptr[2 * grid_len],
+                        in_ptr[3 * grid_len], cell / grid_w, cell % grid_w, stride, anchor, a, obj_ptr[cell],
+                        maxClassProbs, block_idx[bit - first]);
+        // 增加有效目标计数
+        validCount++;
+      }
+    }
   }
   return validCount; // 返回有效目标的数量
 }
 
-// 后处理函数，对输入的三个检测层的输出进行处理，提取目标检测框信息，并进行非极大值抑制      实际上也就是他这里的yolo的检测方法
-// 输入：三个检测层的输出，模型输入尺寸，置信度阈值，非极大值抑制阈值，量化参数，检测结果组
-int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h, int model_in_w, float conf_threshold,
-                 float nms_threshold, BOX_RECT pads, float scale_w, float scale_h, std::vector<int32_t> &qnt_zps,
-                 std::vector<float> &qnt_scales, DetectResultsGroup *group)
-{
-  memset(group, 0, sizeof(DetectResultsGroup));
-
-  std::vector<float> filterBoxes;
-  std::vector<float> objProbs;
-  std::vector<int> classId;
-
-  // stride 8
-  int stride0 = 8;
-  int grid_h0 = model_in_h / stride0;
-  int grid_w0 = model_in_w / stride0;
-  int validCount0 = 0;
-  validCount0 = process(input0, (int *)anchor0, grid_h0, grid_w0, model_in_h, model_in_w, stride0, filterBoxes, objProbs,
-                        classId, conf_threshold, qnt_zps[0], qnt_scales[0]);
-
-  // stride 16
-  int stride1 = 16;
-  int grid_h1 = model_in_h / stride1;
-  int grid_w1 = model_in_w / stride1;
-  int validCount1 = 0;
-  validCount1 = process(input1, (int *)anchor1, grid_h1, grid_w1, model_in_h, model_in_w, stride1, filterBoxes, objProbs,
-                        classId, conf_threshold, qnt_zps[1], qnt_scales[1]);
-
-  // stride 32
-  int stride2 = 32;
-  int grid_h2 = model_in_h / stride2;
-  int grid_w2 = model_in_w / stride2;
-  int validCount2 = 0;
-  validCount2 = process(input2, (int *)anchor2, grid_h2, grid_w2, model_in_h, model_in_w, stride2, filterBoxes, objProbs,
-                        classId, conf_threshold, qnt_zps[2], qnt_scales[2]);
-
-  int validCount = validCount0 + validCount1 + validCount2;
-  // no object detect
-  if (validCount <= 0)
+// 处理NPU原生布局（NHWC / NC1HWC2）的输出，参数同process
+// box置信度按间隔收集成块后做同样的向量比较，候选顺序与NCHW相同；每个候选的类别概率在内存中连续，逐网格单元求最大值
+template <int NC>
+int Decoder<NC>::process_native(int8_t *input, const DecodeLayout *layout, int h,
+                                int a_begin, int a_end, int cell_begin, int cell_end, PostProcessWorkspace *ws,
+                                int offset, const HeadQuantTable &table, const uint64_t *cell_mask,
+                                const uint8_t *active_classes, int num_active)
+{
+  int num_classes = NC > 0 ? NC : layout->num_classes;
+  const int prop_size = 5 + num_classes; // 每个锚点的通道数
+  const int *anchor = layout->anchor[h];
+  int grid_w = layout->grid_w[h], stride = layout->stride[h];
+  HeadView view = make_head_view(input, layout, h);
+  int validCount = 0; // 有效目标计数
+  int8_t thres_i8 = table.thres_i8; // 阈值的量化值
+  int8_t obj_block[64];   // 收集到的块内box置信度
+  int8_t cls_buf[DECODE_MAX_CLASSES]; // NC1HWC2跨C2块时收集的类别概率
+  int8_t box_buf[4];      // NC1HWC2跨C2块时收集的box参数
+
+  for (int a = a_begin; a < a_end; a++)
+  {
+    for (int base = cell_begin; base < cell_end; base += 64)
+    {
+      int n = cell_end - base < 64 ? cell_end - base : 64;
+      const int8_t *obj = load_cells(view, prop_size * a + 4, base, n, obj_block);
+      uint64_t mask = scan_ge_mask64(obj, n, thres_i8); // box置信度 >= 阈值的网格单元
+      if (cell_mask)
+        mask &= cell_mask[base >> 6]; // 只保留位图中需要解码的网格单元
+
+      while (mask)
+      {
+        int bit = lowest_bit(mask);
+        mask &= mask - 1;
+        int cell = base + bit;
+
+        int maxClassId;
+        const int8_t *cls = load_channels(view, prop_size * a + 5, cell, num_classes, cls_buf);
+        int8_t maxClassProbs = argmax_cell(cls, num_classes, active_classes, num_active, &maxClassId);
+        if (maxClassProbs <= thres_i8)
+          continue;
+
+        const int8_t *box = load_channels(view, prop_size * a, cell, 4, box_buf);
+        write_candidate(ws, offset + validCount, table, box[0], box[1], box[2], box[3], cell / grid_w,
+                        cell % grid_w, stride, anchor, a, obj[bit], maxClassProbs, maxClassId);
+        validCount++;
+      }
+    }
+  }
+  return validCount;
+}
+
+// 根据三个输出头的维度构建解码布局：类别数取自通道数，步长由输入尺寸与网格尺寸之比得到，锚点按步长选取
+int build_decode_layout(DecodeLayout *layout, int model_in_h, int model_in_w,
+                        const int *channels, const int *grid_h, const int *grid_w)
+{
+  memset(layout, 0, sizeof(DecodeLayout));
+  for (int h = 0; h < OBJ_HEAD_NUM; h++)
+  {
+    if (channels[h] % OBJ_ANCHOR_NUM != 0 || channels[h] / OBJ_ANCHOR_NUM <= 5 || grid_h[h] <= 0 || grid_w[h] <= 0)
+    {
+      printf("output %d dims not yolov5 layout: channels=%d grid=%dx%d\n", h, channels[h], grid_h[h], grid_w[h]);
+      return -1;
+    }
+    int num_classes = channels[h] / OBJ_ANCHOR_NUM - 5;
+    if (num_classes > DECODE_MAX_CLASSES)
+    {
+      printf("output %d class num %d exceeds %d\n", h, num_classes, DECODE_MAX_CLASSES);
+      return -1;
+    }
+    if (h > 0 && num_classes != layout->num_classes)
+    {
+      printf("output %d class num %d differs from output 0 class num %d\n", h, num_classes, layout->num_classes);
+      return -1;
+    }
+    layout->num_classes = num_classes;
+    layout->prop_size = 5 + num_classes;
+    layout->grid_h[h] = grid_h[h];
+    layout->grid_w[h] = grid_w[h];
+    layout->stride[h] = model_in_h / grid_h[h];
+    layout->fmt[h] = OUTPUT_NCHW;
+    layout->cell_step[h] = 1;
+    if (model_in_w / grid_w[h] != layout->stride[h])
+    {
+      printf("output %d stride mismatch: %d vs %d\n", h, layout->stride[h], model_in_w / grid_w[h]);
+      return -1;
+    }
+    switch (layout->stride[h])
+    {
+    case 8:
+      layout->anchor[h] = anchor0;
+      break;
+    case 16:
+      layout->anchor[h] = anchor1;
+      break;
+    case 32:
+      layout->anchor[h] = anchor2;
+      break;
+    default:
+      printf("output %d stride %d has no anchors\n", h, layout->stride[h]);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// 把一个输出头设置为NPU原生布局：NHWC的cell_step不能小于通道数，NC1HWC2的C2需大于0
+int set_head_format(DecodeLayout *layout, int h, int fmt, int cell_step)
+{
+  int channels = layout->prop_size * OBJ_ANCHOR_NUM;
+  if ((fmt == OUTPUT_NCHW && cell_step != 1) || (fmt == OUTPUT_NHWC && cell_step < channels) ||
+      (fmt == OUTPUT_NC1HWC2 && cell_step <= 0) || fmt < OUTPUT_NCHW || fmt > OUTPUT_NC1HWC2)
+  {
+    printf("output %d format %d with cell step %d does not fit %d channels\n", h, fmt, cell_step, channels);
+    return -1;
+  }
+  layout->fmt[h] = fmt;
+  layout->cell_step[h] = cell_step;
+  return 0;
+}
+
+// 按布局和类别数分派到特化的解码器，其它类别数走通用版本
+template <int NC>
+static inline int decode_head_fixed(int8_t *input, const DecodeLayout *layout, int h, int a_begin, int a_end,
+                                    int cell_begin, int cell_end, PostProcessWorkspace *ws, int offset,
+                                    const HeadQuantTable &table, const uint64_t *cell_mask,
+                                    const uint8_t *active_classes, int num_active)
+{
+  if (layout->fmt[h] == OUTPUT_NCHW)
+    return Decoder<NC>::process(input, layout, h, a_begin, a_end, cell_begin, cell_end, ws, offset, table,
+                                cell_mask, active_classes, num_active);
+  return Decoder<NC>::process_native(input, layout, h, a_begin, a_end, cell_begin, cell_end, ws, offset, table,
+                                     cell_mask, active_classes, num_active);
+}
+
+static int decode_head(int8_t *input, const DecodeLayout *layout, int h, int a_begin, int a_end, int cell_begin, int cell_end,
+                       PostProcessWorkspace *ws, int offset, const HeadQuantTable &table, const uint64_t *cell_mask,
+                       const uint8_t *active_classes, int num_active)
+{
+  switch (layout->num_classes)
+  {
+  case 10:
+    return decode_head_fixed<10>(input, layout, h, a_begin, a_end, cell_begin, cell_end, ws, offset, table,
+                                 cell_mask, active_classes, num_active);
+  case 15:
+    return decode_head_fixed<15>(input, layout, h, a_begin, a_end, cell_begin, cell_end, ws, offset, table,
+                                 cell_mask, active_classes, num_active);
+  case 25:
+    return decode_head_fixed<25>(input, layout, h, a_begin, a_end, cell_begin, cell_end, ws, offset, table,
+                                 cell_mask, active_classes, num_active);
+  default:
+    return decode_head_fixed<0>(input, layout, h, a_begin, a_end, cell_begin, cell_end, ws, offset, table,
+                                cell_mask, active_classes, num_active);
+  }
+}
+
+// 帧内并行解码的一个任务：一个输出头的一个anchor上的一段行带
+typedef struct _DecodeTask
+{
+  int head;       // 输出头
+  int anchor;     // anchor
+  int cell_begin; // 行带起始网格单元（按64对齐）
+  int cell_end;   // 行带结束网格单元（不含）
+  int offset;     // 候选在工作区中的写入起点，即该行带在串行解码中最多能排到的位置，各任务的写入区间互不重叠
+  int count;      // 解得的候选数
+} DecodeTask;
+
+#define DECODE_MAX_TASKS (OBJ_HEAD_NUM * OBJ_ANCHOR_NUM * (DECODE_MAX_BANDS + 1))
+
+// 把解码拆成任务：最细尺度每个anchor按行切成bands个行带（行带边界按64个网格单元对齐），较粗尺度按同样的行带大小切分
+// 任务按串行解码的顺序（输出头、anchor、网格单元）排列，返回任务数
+static int build_decode_tasks(const DecodeLayout *layout, int bands, int skip_head, DecodeTask *tasks)
+{
+  int fine = 0;
+  for (int h = 1; h < OBJ_HEAD_NUM; h++)
+  {
+    if (layout->grid_h[h] * layout->grid_w[h] > layout->grid_h[fine] * layout->grid_w[fine])
+      fine = h;
+  }
+  int band_rows = (layout->grid_h[fine] + bands - 1) / bands;
+  int band_cells = (band_rows * layout->grid_w[fine] + 63) & ~63;
+
+  int num = 0, base = 0;
+  for (int h = 0; h < OBJ_HEAD_NUM; h++)
   {
+    int grid_len = layout->grid_h[h] * layout->grid_w[h];
+    if (h != skip_head)
+    {
+      for (int a = 0; a < OBJ_ANCHOR_NUM; a++)
+      {
+        for (int c = 0; c < grid_len; c += band_cells)
+        {
+          DecodeTask &t = tasks[num++];
+          t.head = h;
+          t.anchor = a;
+          t.cell_begin = c;
+          t.cell_end = c + band_cells < grid_len ? c + band_cells : grid_len;
+          t.offset = base + a * grid_len + c;
+          t.count = 0;
+        }
+      }
+    }
+    base += grid_len * OBJ_ANCHOR_NUM;
+  }
+  return num;
+}
+
+// 把工作区中从src开始的count个候选移到dst（dst <= src）
+static void move_candidates(PostProcessWorkspace *ws, int dst, int src, int count)
+{
+  memmove(ws->box_x + dst, ws->box_x + src, count * sizeof(float));
+  memmove(ws->box_y + dst, ws->box_y + src, count * sizeof(float));
+  memmove(ws->box_w + dst, ws->box_w + src, count * sizeof(float));
+  memmove(ws->box_h + dst, ws->box_h + src, count * sizeof(float));
+  memmove(ws->score + dst, ws->score + src, count * sizeof(float));
+  memmove(ws->cls + dst, ws->cls + src, count * sizeof(int32_t));
+}
+
+// 帧内并行解码：各任务提交到共享线程池（第一个任务在当前线程执行），各自写入工作区中互不重叠的区间，
+// 全部完成后按任务顺序把候选紧凑到工作区前部，候选顺序与串行解码完全相同，返回候选总数
+static int decode_parallel(int8_t *const *head_inputs, const DecodeLayout *layout, const PostProcessConfig *config,
+                           int skip_head, const HeadQuantTable *tables, const uint64_t *const *head_masks,
+                           PostProcessWorkspace *ws)
+{
+  int bands = config->decode_bands < 1 ? 1 : (config->decode_bands > DECODE_MAX_BANDS ? DECODE_MAX_BANDS : config->decode_bands);
+  DecodeTask tasks[DECODE_MAX_TASKS];
+  int num = build_decode_tasks(layout, bands, skip_head, tasks);
+  if (num == 0)
     return 0;
+
+  auto run = [&](int i) {
+    DecodeTask &t = tasks[i];
+    t.count = decode_head(head_inputs[t.head], layout, t.head, t.anchor, t.anchor + 1, t.cell_begin, t.cell_end, ws,
+                          t.offset, tables[t.head], head_masks[t.head], config->active_classes,
+                          config->num_active_classes);
+  };
+  std::future<void> done[DECODE_MAX_TASKS];
+  for (int i = 1; i < num; i++)
+    done[i] = config->decode_pool->submit([&run, i]() { run(i); });
+  run(0);
+  for (int i = 1; i < num; i++)
+    done[i].get();
+
+  int validCount = 0;
+  for (int i = 0; i < num; i++)
+  {
+    if (tasks[i].count > 0 && tasks[i].offset != validCount)
+      move_candidates(ws, validCount, tasks[i].offset, tasks[i].count);
+    validCount += tasks[i].count;
   }
+  return validCount;
+}
 
-  std::vector<int> indexArray;
-  for (int i = 0; i < validCount; ++i)
+// count个元素按64字节对齐后占用的字节数
+static size_t aligned_bytes(size_t count, size_t elem_size)
+{
+  return (count * elem_size + 63) & ~(size_t)63;
+}
+
+// 从整块内存中切出count个元素的数组，游标按64字节对齐前进
+static void *carve(char **cursor, size_t count, size_t elem_size)
+{
+  void *p = *cursor;
+  *cursor += aligned_bytes(count, elem_size);
+  return p;
+}
+
+// 分配后处理工作区：各数组大小由三个输出头的网格数确定，一次分配后按64字节对齐切分
+int init_postprocess_workspace(PostProcessWorkspace *ws, const DecodeLayout *layout, int model_in_h, int model_in_w)
+{
+  memset(ws, 0, sizeof(PostProcessWorkspace));
+  int capacity = 0;
+  for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    capacity += layout->grid_h[h] * layout->grid_w[h] * OBJ_ANCHOR_NUM;
+  int grid_cells = ((model_in_w + NMS_GRID_CELL - 1) / NMS_GRID_CELL) * ((model_in_h + NMS_GRID_CELL - 1) / NMS_GRID_CELL);
+  size_t nodes = (size_t)capacity * NMS_GRID_MAX_CELLS; // 每个已保留框最多登记到NMS_GRID_MAX_CELLS个网格
+  int max_grid_len = 0;
+  for (int h = 0; h < OBJ_HEAD_NUM; h++)
   {
-    indexArray.push_back(i);
+    if (layout->grid_h[h] * layout->grid_w[h] > max_grid_len)
+      max_grid_len = layout->grid_h[h] * layout->grid_w[h];
   }
+  int mask_words = (max_grid_len + 63) / 64;
 
-  quick_sort_indice_inverse(objProbs, 0, validCount - 1, indexArray);
+  // 12个capacity长度的数组，加上已保留框坐标/类别、网格链表头、链表节点和由粗到细解码的位图
+  size_t total = 12 * aligned_bytes(capacity, 4) + aligned_bytes((size_t)capacity * 10, sizeof(float)) +
+                 aligned_bytes((size_t)capacity * 2, sizeof(int32_t)) + aligned_bytes(grid_cells, sizeof(int)) +
+                 2 * aligned_bytes(nodes, sizeof(int)) + aligned_bytes(mask_words, sizeof(uint64_t));
+  if (posix_memalign(&ws->mem, 64, total) != 0)
+  {
+    printf("postprocess workspace malloc failure, size=%zu\n", total);
+    ws->mem = NULL;
+    return -1;
+  }
 
-  std::set<int> class_set(std::begin(classId), std::end(classId));
+  char *cursor = (char *)ws->mem;
+  ws->box_x = (float *)carve(&cursor, capacity, sizeof(float));
+  ws->box_y = (float *)carve(&cursor, capacity, sizeof(float));
+  ws->box_w = (float *)carve(&cursor, capacity, sizeof(float));
+  ws->box_h = (float *)carve(&cursor, capacity, sizeof(float));
+  ws->score = (float *)carve(&cursor, capacity, sizeof(float));
+  ws->cls = (int32_t *)carve(&cursor, capacity, sizeof(int32_t));
+  ws->order = (int *)carve(&cursor, capacity, sizeof(int));
+  ws->order_tmp = (int *)carve(&cursor, capacity, sizeof(int));
+  ws->keys = (uint32_t *)carve(&cursor, capacity, sizeof(uint32_t));
+  ws->keys_tmp = (uint32_t *)carve(&cursor, capacity, sizeof(uint32_t));
+  ws->seen_by = (int *)carve(&cursor, capacity, sizeof(int));
+  ws->wide_boxes = (int *)carve(&cursor, capacity, sizeof(int));
+  ws->kept_coords = (float *)carve(&cursor, (size_t)capacity * 10, sizeof(float));
+  ws->kept_cls = (int32_t *)carve(&cursor, (size_t)capacity * 2, sizeof(int32_t));
+  ws->cell_head = (int *)carve(&cursor, grid_cells, sizeof(int));
+  ws->node_box = (int *)carve(&cursor, nodes, sizeof(int));
+  ws->node_next = (int *)carve(&cursor, nodes, sizeof(int));
+  ws->cell_mask = (uint64_t *)carve(&cursor, mask_words, sizeof(uint64_t));
+  ws->cell_mask_words = mask_words;
+  ws->capacity = capacity;
+  ws->grid_cells = grid_cells;
+  return 0;
+}
+
+// 释放后处理工作区
+void release_postprocess_workspace(PostProcessWorkspace *ws)
+{
+  if (ws->mem)
+    free(ws->mem);
+  memset(ws, 0, sizeof(PostProcessWorkspace));
+}
+
+// 把位图中[lo, hi]区间的位置1
+static void set_bit_range(uint64_t *words, int lo, int hi)
+{
+  for (int b = lo; b <= hi; b++)
+    words[b >> 6] |= (uint64_t)1 << (b & 63);
+}
+
+// 扫描粗尺度输出头的box置信度（跳过忽略区域），对每个活跃网格单元，把最细尺度上对应区域（向外扩一个粗网格单元）在位图中置1
+// 返回粗尺度活跃网格单元数
+static int mark_coarse_activity(int8_t *input, const DecodeLayout *layout, int coarse, int fine,
+                                int8_t thres_i8, const uint64_t *allow_mask, uint64_t *cell_mask)
+{
+  HeadView view = make_head_view(input, layout, coarse);
+  int8_t obj_block[64];
+  int gh_c = layout->grid_h[coarse], gw_c = layout->grid_w[coarse];
+  int gh_f = layout->grid_h[fine], gw_f = layout->grid_w[fine];
+  int grid_len = gh_c * gw_c;
+  int active = 0;
+  for (int a = 0; a < OBJ_ANCHOR_NUM; a++)
+  {
+    for (int base = 0; base < grid_len; base += 64)
+    {
+      int n = grid_len - base < 64 ? grid_len - base : 64;
+      uint64_t mask = scan_ge_mask64(load_cells(view, layout->prop_size * a + 4, base, n, obj_block), n, thres_i8);
+      if (allow_mask)
+        mask &= allow_mask[base >> 6]; // 忽略区域内的粗网格不算活跃
+      while (mask)
+      {
+        int cell = base + lowest_bit(mask);
+        mask &= mask - 1;
+        active++;
+        int ci = cell / gw_c, cj = cell % gw_c;
+        // 粗网格 [ci - 1, ci + 1] 行、[cj - 1, cj + 1] 列对应的最细尺度网格范围
+        int r0 = (ci > 0 ? ci - 1 : 0) * gh_f / gh_c;
+        int r1 = ((ci + 2) * gh_f + gh_c - 1) / gh_c - 1;
+        int c0 = (cj > 0 ? cj - 1 : 0) * gw_f / gw_c;
+        int c1 = ((cj + 2) * gw_f + gw_c - 1) / gw_c - 1;
+        if (r1 > gh_f - 1)
+          r1 = gh_f - 1;
+        if (c1 > gw_f - 1)
+          c1 = gw_f - 1;
+        for (int r = r0; r <= r1; r++)
+          set_bit_range(cell_mask, r * gw_f + c0, r * gw_f + c1);
+      }
+    }
+  }
+  return active;
+}
+
+// 判断原图上的一点是否落在任一忽略区域内（多边形边上也算）
+static bool in_ignore_regions(const IgnoreRegions *regions, float x, float y)
+{
+  for (const auto &r : regions->rects)
+  {
+    if (x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height)
+      return true;
+  }
+  for (const auto &poly : regions->polygons)
+  {
+    if (poly.size() >= 3 && cv::pointPolygonTest(poly, cv::Point2f(x, y), false) >= 0)
+      return true;
+  }
+  return false;
+}
+
+// 构建各输出头允许解码的网格单元位图：网格单元中心（模型输入坐标）去掉填充并按缩放比例映射回原图后判断
+int build_ignore_masks(const IgnoreRegions *regions, const DecodeLayout *layout, BOX_RECT pads,
+                       float scale_w, float scale_h, std::vector<uint64_t> *masks)
+{
+  int ignored = 0;
+  for (int h = 0; h < OBJ_HEAD_NUM; h++)
+  {
+    int grid_h = layout->grid_h[h], grid_w = layout->grid_w[h], stride = layout->stride[h];
+    masks[h].assign((grid_h * grid_w + 63) / 64, 0);
+    for (int i = 0; i < grid_h; i++)
+    {
+      for (int j = 0; j < grid_w; j++)
+      {
+        float x = ((j + 0.5f) * stride - pads.left) / scale_w;
+        float y = ((i + 0.5f) * stride - pads.top) / scale_h;
+        int cell = i * grid_w + j;
+        if (in_ignore_regions(regions, x, y))
+          ignored++;
+        else
+          masks[h][cell >> 6] |= (uint64_t)1 << (cell & 63);
+      }
+    }
+  }
+  return ignored;
+}
+
+// 后处理函数，对输入的三个检测层的输出进行处理，提取目标检测框信息，并进行非极大值抑制      实际上也就是他这里的yolo的检测方法
+// 输入：三个检测层的输出，模型输入尺寸，后处理配置（NMS阈值、候选上限、NMS方式、由粗到细解码），解码布局，三个检测层的量化查找表（含置信度阈值），工作区，检测结果组
+int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h, int model_in_w,
+                 const PostProcessConfig *config, BOX_RECT pads, float scale_w, float scale_h,
+                 const DecodeLayout *layout, const HeadQuantTable *tables, PostProcessWorkspace *ws,
+                 DetectResultsGroup *group)
+{
+  group->dets.clear();
 
-  for (auto c : class_set)
+  float nms_threshold = config->nms_threshold;
+  int8_t *head_inputs[OBJ_HEAD_NUM] = {input0, input1, input2};
+  // 静态忽略区域的位图在扫描box置信度时与扫描结果相与，被忽略的网格单元不做类别argmax
+  const uint64_t *head_masks[OBJ_HEAD_NUM];
+  for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    head_masks[h] = config->cell_masks[h];
+
+  // 由粗到细：先扫描粗尺度的box置信度（阈值放宽coarse_margin），最细尺度只解码粗尺度活跃区域附近，粗尺度全空时跳过
+  int fine = -1;
+  bool skip_fine = false;
+  if (config->coarse_to_fine)
   {
-    nms(validCount, filterBoxes, classId, indexArray, c, nms_threshold);
+    fine = 0;
+    for (int h = 1; h < OBJ_HEAD_NUM; h++)
+    {
+      if (layout->stride[h] < layout->stride[fine])
+        fine = h;
+    }
+    memset(ws->cell_mask, 0, ws->cell_mask_words * sizeof(uint64_t));
+    int active = 0;
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    {
+      if (h == fine)
+        continue;
+      int8_t coarse_thres = qnt_f32_to_affine(tables[h].conf_threshold - config->coarse_margin, tables[h].zp, tables[h].scale);
+      active += mark_coarse_activity(head_inputs[h], layout, h, fine, coarse_thres, config->cell_masks[h], ws->cell_mask);
+    }
+    skip_fine = (active == 0);
+    if (config->cell_masks[fine])
+    {
+      int words = (layout->grid_h[fine] * layout->grid_w[fine] + 63) / 64;
+      for (int w = 0; w < words; w++)
+        ws->cell_mask[w] &= config->cell_masks[fine][w];
+    }
+    head_masks[fine] = ws->cell_mask;
   }
 
+  // 三个输出头，网格尺寸、步长和锚点由解码布局给出，候选依次写入工作区；设置了共享线程池时按输出头和行带并行解码
+  int validCount = 0;
+  if (config->decode_pool)
+  {
+    validCount = decode_parallel(head_inputs, layout, config, skip_fine ? fine : -1, tables, head_masks, ws);
+  }
+  else
+  {
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    {
+      if (h == fine && skip_fine)
+        continue;
+      validCount += decode_head(head_inputs[h], layout, h, 0, OBJ_ANCHOR_NUM, 0, layout->grid_h[h] * layout->grid_w[h],
+                                ws, validCount, tables[h], head_masks[h], config->active_classes,
+                                config->num_active_classes);
+    }
+  }
+  // no object detect
+  if (validCount <= 0)
+  {
+    return 0;
+  }
+
+  // 按得分从高到低稳定排序，设置了候选上限时只保留得分最高的max_candidates个
+  int *indexArray = ws->order;
+  validCount = sort_scores_desc(ws->score, validCount, config->max_candidates, indexArray,
+                                ws->keys, ws->keys_tmp, ws->order_tmp);
+
+  // 所有类别一次完成NMS，已保留框（及网格模式下的邻近框）的坐标、面积共用工作区中的一块缓冲区
+  BoxSoA kept, near;
+  kept.x1 = ws->kept_coords;
+  kept.y1 = kept.x1 + validCount;
+  kept.x2 = kept.y1 + validCount;
+  kept.y2 = kept.x2 + validCount;
+  kept.area = kept.y2 + validCount;
+  kept.cls = ws->kept_cls;
+  kept.count = 0;
+  near.x1 = kept.area + validCount;
+  near.y1 = near.x1 + validCount;
+  near.x2 = near.y1 + validCount;
+  near.y2 = near.x2 + validCount;
+  near.area = near.y2 + validCount;
+  near.cls = kept.cls + validCount;
+  near.count = 0;
+  // 网格模式依赖IoU > 0需要框相交，阈值不为正时仍使用逐对比较
+  if (config->nms_mode == NMS_GRID && nms_threshold > 0.f)
+    nms_grid(validCount, ws, indexArray, nms_threshold, model_in_h, model_in_w, &kept, &near);
+  else
+    nms(validCount, ws, indexArray, nms_threshold, &kept);
+
   /* box valid detect target */
+  int content_w = model_in_w - pads.left - pads.right;  // 模型输入中实际图像区域的尺寸
+  int content_h = model_in_h - pads.top - pads.bottom;
   for (int i = 0; i < validCount; ++i)
   {
     // if (indexArray[i] == -1 || last_count >= OBJ_NUMB_MAX_SIZE)
@@ -331,20 +1003,21 @@ int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h,
     }
     int n = indexArray[i];
 
-    float x1 = filterBoxes[n * 4 + 0] - pads.left;
-    float y1 = filterBoxes[n * 4 + 1] - pads.top;
-    float x2 = x1 + filterBoxes[n * 4 + 2];
-    float y2 = y1 + filterBoxes[n * 4 + 3];
-    int id = classId[n];
-    float obj_conf = objProbs[i];
+    float x1 = ws->box_x[n] - pads.left;
+    float y1 = ws->box_y[n] - pads.top;
+    float x2 = x1 + ws->box_w[n];
+    float y2 = y1 + ws->box_h[n];
+    int id = ws->cls[n];
+    float obj_conf = ws->score[n];
 
     DetectionBox new_box;
-    int _x1 = (int)(clamp(x1, 0, model_in_w) / scale_w);
-    int _y1 = (int)(clamp(y1, 0, model_in_h) / scale_h);
-    int _x2 = (int)(clamp(x2, 0, model_in_w) / scale_w);
-    int _y2 = (int)(clamp(y2, 0, model_in_h) / scale_h);
+    // 去掉填充后裁剪到图像区域内，letterbox时避免框落在填充区映射到原图外
+    int _x1 = (int)(clamp(x1, 0, content_w) / scale_w);
+    int _y1 = (int)(clamp(y1, 0, content_h) / scale_h);
+    int _x2 = (int)(clamp(x2, 0, content_w) / scale_w);
+    int _y2 = (int)(clamp(y2, 0, content_h) / scale_h);
     new_box.box = cv::Rect_<int>(_x1, _y1, _x2 - _x1, _y2 - _y1);
-    new_box.score = objProbs[i];
+    new_box.score = obj_conf;
     new_box.obj_id = id;  // 保存原始的ID
     
     // 模型类型会在RkPt::infer函数中设置
@@ -424,8 +1097,8 @@ static void initializeRandColors()
   init_colors = true;
 }
 
-// 显示检测结果，找到矩形中心点，画红圆
-void show_draw_results(DetectResultsGroup &results_group)
+// 显示检测结果，找到矩形中心点，画红圆（帧数据只读，绘制到调用方提供的canvas上）
+void show_draw_results(DetectResultsGroup &results_group, cv::Mat &canvas)
 {
   if (!init_colors)
   {
@@ -435,12 +1108,12 @@ void show_draw_results(DetectResultsGroup &results_group)
   for (const auto& res : results_group.dets)
   {
     sprintf(text, "%s", res.det_name.c_str());
-    cv::rectangle(results_group.cur_img, res.box, randColor[1], 2, 8, 0);
-    cv::putText(results_group.cur_img, text, cv::Point(res.box.x, res.box.y + 12), cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255));
+    cv::rectangle(canvas, res.box, randColor[1], 2, 8, 0);
+    cv::putText(canvas, text, cv::Point(res.box.x, res.box.y + 12), cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255));
     
     int cv_center_x = res.box.x + res.box.width / 2;
     int cv_center_y = res.box.y + res.box.height / 2;
     
-    cv::circle(results_group.cur_img, cv::Point(cv_center_x, cv_center_y), 10, cv::Scalar(0, 0, 255), -1, cv::LINE_AA);
+    cv::circle(canvas, cv::Point(cv_center_x, cv_center_y), 10, cv::Scalar(0, 0, 255), -1, cv::LINE_AA);
   }
 }
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <algorithm>
 #include "rga/im2d.h"
 #include "rga/rga.h"
 #include "opencv2/core/core.hpp"
@@ -25,30 +26,75 @@ void letterbox(const cv::Mat &image, cv::Mat &padded_image, BOX_RECT &pads, cons
     // 在图像周围添加填充
     cv::copyMakeBorder(resized_image, padded_image, pads.top, pads.bottom, pads.left, pads.right, cv::BORDER_CONSTANT, pad_color);
 }
-//使用 RGA（Rockchip Graphic Acceleration）硬件加速库将输入图像调整为指定目标尺寸，这个貌似也没有用到
-int resize_rga(rga_buffer_t &src, rga_buffer_t &dst, const cv::Mat &image, cv::Mat &resized_image, const cv::Size &target_size)
+//计算letterbox的图像区域：按较小的缩放比例保持宽高比缩放，剩余部分平均分到两侧填充（与letterbox()相同）
+cv::Rect letterbox_rect(const cv::Size &image_size, const cv::Size &target_size, BOX_RECT &pads, float &scale_w, float &scale_h)
 {
-    im_rect src_rect;
-    im_rect dst_rect;
-    memset(&src_rect, 0, sizeof(src_rect));
-    memset(&dst_rect, 0, sizeof(dst_rect));
-    size_t img_width = image.cols;
-    size_t img_height = image.rows;
-    if (image.type() != CV_8UC3)
+    float scale = std::min((float)target_size.width / image_size.width, (float)target_size.height / image_size.height);
+    int resized_width = std::min((int)(image_size.width * scale + 0.5f), target_size.width);
+    int resized_height = std::min((int)(image_size.height * scale + 0.5f), target_size.height);
+
+    int pad_width = target_size.width - resized_width;
+    int pad_height = target_size.height - resized_height;
+    pads.left = pad_width / 2;
+    pads.right = pad_width - pads.left;
+    pads.top = pad_height / 2;
+    pads.bottom = pad_height - pads.top;
+
+    // 按实际缩放后的尺寸计算比例，框坐标去掉填充后按该比例映射回原图
+    scale_w = (float)resized_width / image_size.width;
+    scale_h = (float)resized_height / image_size.height;
+    return cv::Rect(pads.left, pads.top, resized_width, resized_height);
+}
+
+//一次RGA任务完成颜色转换和缩放：源格式为BGR888、目标格式为RGB888，RGA在缩放的同时交换R/B通道，
+//结果直接写入模型输入缓冲区中的dst_rect区域，CPU不再对整帧或缩放后的图像做颜色转换；
+//模型输入为NPU内存时按导入的句柄访问，RGA直接写入NPU读取的那块内存
+int convert_resize_rga(const cv::Mat &image, cv::Mat &dst, const cv::Rect &dst_rect, rga_buffer_handle_t dst_handle)
+{
+    if (image.type() != CV_8UC3 || dst.type() != CV_8UC3 || image.step % 3 != 0 || dst.step % 3 != 0)
     {
-        printf("source image type is %d!\n", image.type());
+        printf("rga preprocess needs CV_8UC3 images, src type %d, dst type %d\n", image.type(), dst.type());
         return -1;
     }
-    size_t target_width = target_size.width;
-    size_t target_height = target_size.height;
-    src = wrapbuffer_virtualaddr((void *)image.data, img_width, img_height, RK_FORMAT_RGB_888);
-    dst = wrapbuffer_virtualaddr((void *)resized_image.data, target_width, target_height, RK_FORMAT_RGB_888);
-    int ret = imcheck(src, dst, src_rect, dst_rect);
+    rga_buffer_t src = wrapbuffer_virtualaddr((void *)image.data, image.cols, image.rows, RK_FORMAT_BGR_888,
+                                              (int)(image.step / 3), image.rows);
+    rga_buffer_t dst_buf;
+    if (dst_handle != 0)
+        dst_buf = wrapbuffer_handle(dst_handle, dst.cols, dst.rows, RK_FORMAT_RGB_888, (int)(dst.step / 3), dst.rows);
+    else
+        dst_buf = wrapbuffer_virtualaddr((void *)dst.data, dst.cols, dst.rows, RK_FORMAT_RGB_888,
+                                         (int)(dst.step / 3), dst.rows);
+    rga_buffer_t pat;
+    im_rect src_rect = {0, 0, image.cols, image.rows};
+    im_rect dst_rect_rga = {dst_rect.x, dst_rect.y, dst_rect.width, dst_rect.height};
+    im_rect pat_rect;
+    memset(&pat, 0, sizeof(pat));
+    memset(&pat_rect, 0, sizeof(pat_rect));
+
+    int ret = imcheck(src, dst_buf, src_rect, dst_rect_rga);
     if (IM_STATUS_NOERROR != ret)
     {
-        fprintf(stderr, "rga check error! %s", imStrError((IM_STATUS)ret));
+        fprintf(stderr, "rga check error! %s\n", imStrError((IM_STATUS)ret));
+        return -1;
+    }
+    IM_STATUS status = improcess(src, dst_buf, pat, src_rect, dst_rect_rga, pat_rect, IM_SYNC);
+    if (status != IM_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "rga process error! %s\n", imStrError(status));
         return -1;
     }
-    IM_STATUS STATUS = imresize(src, dst);
     return 0;
-}
\ No newline at end of file
+}
+
+//CPU回退路径：缩放到dst_rect区域后只在该区域内原地转换为RGB，尺寸一致时直接转换到该区域
+void convert_resize_cpu(const cv::Mat &image, cv::Mat &dst, const cv::Rect &dst_rect)
+{
+    cv::Mat roi = dst(dst_rect);
+    if (image.cols == dst_rect.width && image.rows == dst_rect.height)
+    {
+        cv::cvtColor(image, roi, cv::COLOR_BGR2RGB);
+        return;
+    }
+    cv::resize(image, roi, cv::Size(dst_rect.width, dst_rect.height), 0, 0, cv::INTER_LINEAR);
+    cv::cvtColor(roi, roi, cv::COLOR_BGR2RGB);
+}
@@ -1,7 +1,9 @@
 #include <stdio.h>
+#include <sys/time.h>
 #include <iomanip>
 #include <sstream>
 #include <mutex>
+#include <algorithm>
 
 #include <iostream>
 
@@ -16,13 +18,7 @@
 
 #include "coreNum.hpp"  // 核心数量相关头文件
 #include "rkpt.hpp"  // RKPT类头文件
-
-// 添加到类定义之前
-// 定义模型类型
-enum ModelType {
-    MODEL_MATERIAL = 0, // 物资识别模型
-    MODEL_DIGIT = 1     // 数字识别模型
-};
+#include "model_cache.h"  // 共享的模型文件映射
 
 ///////////////////这个文件主要是把图像转换为他这里的yolo要用的数字形式，并且调用rknn模型进行推理///////////////////////
 
@@ -38,80 +34,64 @@ static void dump_tensor_attr(rknn_tensor_attr *attr)
 
 }
 
-// 从文件中加载数据
-static unsigned char *load_data(FILE *fp, size_t ofst, size_t sz)
-{
-    unsigned char *data;
-    int ret;
-
-    data = NULL;
-
-    if (NULL == fp)
-    {
-        return NULL;
-    }
-
-    ret = fseek(fp, ofst, SEEK_SET);  // 设置文件指针位置
-    if (ret != 0)
-    {
-        printf("blob seek failure.\n");
-        return NULL;
-    }
-
-    data = (unsigned char *)malloc(sz);  // 分配内存
-    if (data == NULL)
-    {
-        printf("buffer malloc failure.\n");
-        return NULL;
-    }
-    ret = fread(data, 1, sz, fp);  // 读取数据
-    return data;
-}
-
-// 加载模型文件
-static unsigned char *load_model(const char *filename, int *model_size)
-{
-    FILE *fp;
-    unsigned char *data;
-
-    fp = fopen(filename, "rb");  // 打开模型文件
-    if (NULL == fp)
-    {
-        printf("Open file %s failed.\n", filename);
-        return NULL;
-    }
-
-    fseek(fp, 0, SEEK_END);  // 定位到文件末尾
-    int size = ftell(fp);  // 获取文件大小
-
-    data = load_data(fp, 0, size);  // 加载文件数据
-
-    fclose(fp);  // 关闭文件
-
-    *model_size = size;  // 设置模型大小
-    return data;
-}
-
 // RKPT类构造函数
 RkPt::RkPt(const std::string &model_path)
 {
     this->model_path = model_path;  // 初始化模型路径
-    nms_threshold = NMS_THRESH;      // 默认的NMS阈值为0.45
+    pp_config.nms_threshold = NMS_THRESH; // 默认的NMS阈值为0.45
     box_conf_threshold = BOX_THRESH; // 默认的置信度阈值为0.45
     model_type = MODEL_MATERIAL;     // 默认为物资识别模型
+    pp_config.max_candidates = 0;    // 默认不限制NMS前的候选数
+    pp_config.nms_mode = NMS_PAIRWISE; // 默认逐对比较的NMS
+    pp_config.coarse_to_fine = false;  // 默认解码全部输出头
+    pp_config.coarse_margin = COARSE_MARGIN;
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+        pp_config.cell_masks[h] = NULL;  // 默认没有忽略区域
+    ignore_img_width = -1;
+    ignore_img_height = -1;
+    pp_config.active_classes = NULL;  // 默认全部类别参与解码
+    pp_config.num_active_classes = 0;
+    decode_layout.num_classes = 0;
+    pp_config.decode_pool = NULL;     // 默认在推理线程上串行解码
+    pp_config.decode_bands = 4;
+    input_attrs = NULL;
+    output_attrs = NULL;
+    output_mems = NULL;
+    outputs = NULL;
+    native_output = false;
+    broken = false;
+    for (int i = 0; i < INFER_SLOTS; i++)
+    {
+        input_slots[i].mem = NULL;
+        input_slots[i].rga_handle = 0;
+        input_slots[i].canvas_valid = false;
+    }
+    bound_slot = -1;
+    num_jobs = 0;
+    memset(&run_ext, 0, sizeof(run_ext));
+    use_rga = true;                   // 默认用RGA做颜色转换和缩放
+    letterbox_mode = false;           // 默认拉伸到模型输入尺寸
+    geom_img_width = -1;
+    geom_img_height = -1;
+    memset(&pp_workspace, 0, sizeof(pp_workspace));
 }
 
 // RKPT类初始化函数
 int RkPt::init(rknn_context *ctx_in, bool share_weight)
 {
-    printf("Loading model...\n");
-    int model_data_size = 0;
-    model_data = load_model(model_path.c_str(), &model_data_size);  // 加载模型
-    // 模型参数复用
+    // 模型参数复用：复制的上下文不需要模型文件，只有第一个上下文从共享的映射初始化，映射在初始化后即释放
     if (share_weight == true)
+    {
         ret = rknn_dup_context(ctx_in, &ctx);  // 复制上下文
+    }
     else
-        ret = rknn_init(&ctx, model_data, model_data_size, 0, NULL);  // 初始化RKNN上下文
+    {
+        printf("Loading model...\n");
+        ModelView model = ModelCache::instance().acquire(model_path);  // 映射模型文件
+        if (!model)
+            return -1;
+        ret = rknn_init(&ctx, (void *)model->data(), (uint32_t)model->size(), 0, NULL);  // 初始化RKNN上下文
+    }
     if (ret < 0)
     {
         printf("rknn_init error ret=%d\n", ret);
@@ -196,122 +176,659 @@ int RkPt::init(rknn_context *ctx_in, bool share_weight)
     }
     // printf("model input height=%d, width=%d, channel=%d\n", height, width, channel);
 
+    if (build_layout() < 0)  // 根据输出维度确定类别数、步长和锚点
+    {
+        printf("rknn_init output layout error\n");
+        return -1;
+    }
+    if (init_postprocess_workspace(&pp_workspace, &decode_layout, height, width) < 0)  // 分配后处理工作区
+    {
+        printf("rknn_init postprocess workspace error\n");
+        return -1;
+    }
+    build_quant_tables();  // 构建输出头的量化查找表
+
     memset(inputs, 0, sizeof(inputs));  // 初始化输入结构体
     inputs[0].index = 0;
     inputs[0].type = RKNN_TENSOR_UINT8;  // 设置输入数据类型
     inputs[0].size = width * height * channel;  // 设置输入数据大小
     inputs[0].fmt = RKNN_TENSOR_NHWC;  // 设置输入数据格式
     inputs[0].pass_through = 0;
+    for (int i = 0; i < INFER_SLOTS; i++)
+        set_input_memory(i, new HostTensorMemory(width, height, channel));  // 默认主机内存，推理前由rknn_inputs_set拷贝
+
+    // 预分配输出缓冲区：运行时把结果直接写入，不再逐帧分配和释放
+    outputs = (rknn_output *)calloc(io_num.n_output, sizeof(rknn_output));
+    for (int i = 0; i < io_num.n_output; i++)
+    {
+        outputs[i].want_float = 0;  // 设置不需要浮点输出
+        outputs[i].is_prealloc = 1;  // 使用预分配的内存
+        outputs[i].index = i;  // 设置输出索引
+        outputs[i].size = output_attrs[i].size;
+        outputs[i].buf = malloc(outputs[i].size);
+        if (outputs[i].buf == NULL)
+        {
+            printf("output %d buffer malloc failure.\n", i);
+            return -1;
+        }
+    }
 
     return 0;
 }
 
-// 获取RKNN上下文
-rknn_context *RkPt::get_pctx()
+// 根据三个输出头的维度构建解码布局，类别数不再依赖编译期的OBJ_CLASS_NUM
+int RkPt::build_layout()
 {
-    return &ctx;
+    if (io_num.n_output < OBJ_HEAD_NUM)
+    {
+        printf("model output num %d < %d\n", io_num.n_output, OBJ_HEAD_NUM);
+        return -1;
+    }
+    int channels[OBJ_HEAD_NUM], grid_h[OBJ_HEAD_NUM], grid_w[OBJ_HEAD_NUM];
+    for (int i = 0; i < OBJ_HEAD_NUM; i++)
+    {
+        if (output_attrs[i].fmt == RKNN_TENSOR_NHWC)
+        {
+            grid_h[i] = output_attrs[i].dims[1];
+            grid_w[i] = output_attrs[i].dims[2];
+            channels[i] = output_attrs[i].dims[3];
+        }
+        else
+        {
+            channels[i] = output_attrs[i].dims[1];
+            grid_h[i] = output_attrs[i].dims[2];
+            grid_w[i] = output_attrs[i].dims[3];
+        }
+    }
+    ret = build_decode_layout(&decode_layout, height, width, channels, grid_h, grid_w);
+    if (ret < 0)
+        return -1;
+    printf("model class num: %d, strides: %d %d %d\n", decode_layout.num_classes,
+           decode_layout.stride[0], decode_layout.stride[1], decode_layout.stride[2]);
+    return 0;
 }
 
-// 推理函数
-DetectResultsGroup RkPt::infer(cv::Mat &orig_img, int cur_frame_id)
+// 根据三个输出头的zp/scale和当前置信度阈值构建量化查找表
+void RkPt::build_quant_tables()
 {
-    std::lock_guard<std::mutex> lock(mtx);  // 加锁，确保线程安全
-    cv::Mat img;
-    cv::cvtColor(orig_img, img, cv::COLOR_BGR2RGB);  // 将图像转换为RGB格式
-    img_width = img.cols;  // 获取图像宽度
-    img_height = img.rows;  // 获取图像高度
-
-    BOX_RECT pads;
-    memset(&pads, 0, sizeof(BOX_RECT));  // 初始化填充结构体
-    cv::Size target_size(width, height);  // 设置目标尺寸
-    cv::Mat resized_img(target_size.height, target_size.width, CV_8UC3);  // 创建缩放后的图像
-    // 计算缩放比例
-    float scale_w = (float)target_size.width / img.cols;
-    float scale_h = (float)target_size.height / img.rows;
-
-    // 图像缩放
-    if (img_width != width || img_height != height)
-    {
-        // rga
-        rga_buffer_t src;
-        rga_buffer_t dst;
-        memset(&src, 0, sizeof(src));  // 初始化源缓冲区
-        memset(&dst, 0, sizeof(dst));  // 初始化目标缓冲区
-        ret = resize_rga(src, dst, img, resized_img, target_size);  // 使用RGA进行图像缩放
-        if (ret != 0)
+    for (int i = 0; i < 3 && i < (int)io_num.n_output; i++)
+    {
+        int32_t zp = 0;
+        float scale = 1.0f;
+        if ((output_attrs[i].qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC || output_attrs[i].qnt_type == RKNN_TENSOR_QNT_DFP) &&
+            (output_attrs[i].type == RKNN_TENSOR_INT8 || output_attrs[i].type == RKNN_TENSOR_UINT8))
+        {
+            zp = output_attrs[i].zp;  // 量化零点
+            scale = output_attrs[i].scale;  // 量化尺度
+        }
+        else
         {
-            fprintf(stderr, "resize with rga error\n");
+            printf("output %d is not int8 quantized, qnt_type=%d\n", i, output_attrs[i].qnt_type);
         }
+        build_quant_table(&quant_tables[i], zp, scale, box_conf_threshold);
+    }
+}
+
+// 设置置信度和NMS阈值，置信度阈值变化后重建量化查找表
+void RkPt::set_thresholds(float conf_thresh, float nms_thresh)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    box_conf_threshold = conf_thresh;
+    pp_config.nms_threshold = nms_thresh;
+    if (output_attrs)
+        build_quant_tables();
+}
+
+// 设置是否保持宽高比缩放，下一帧推理时重新计算输入几何
+void RkPt::set_letterbox(bool enable)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    letterbox_mode = enable;
+    geom_img_width = -1;
+    geom_img_height = -1;
+}
 
-        inputs[0].buf = resized_img.data;  // 设置输入数据缓冲区
+// 根据当前图像尺寸计算缩放比例、填充和图像区域；letterbox模式下每个输入槽的画布在下次使用时填充一次，
+// 之后每帧只重写图像区域，填充区域保持不变。忽略区域位图依赖缩放和填充，一并标记为需要重建
+void RkPt::update_input_geometry()
+{
+    memset(&input_pads, 0, sizeof(BOX_RECT));
+    if (letterbox_mode)
+    {
+        input_rect = letterbox_rect(cv::Size(img_width, img_height), cv::Size(width, height), input_pads,
+                                    input_scale_w, input_scale_h);
     }
     else
     {
-        inputs[0].buf = img.data;  // 直接使用原始图像数据
+        input_rect = cv::Rect(0, 0, width, height);
+        input_scale_w = (float)width / img_width;
+        input_scale_h = (float)height / img_height;
     }
+    for (int i = 0; i < INFER_SLOTS; i++)
+        input_slots[i].canvas_valid = false;
+    geom_img_width = img_width;
+    geom_img_height = img_height;
+    ignore_img_width = -1;
+    ignore_img_height = -1;
+    printf("input geometry for %dx%d image: region %dx%d at (%d, %d), %s\n", img_width, img_height, input_rect.width,
+           input_rect.height, input_rect.x, input_rect.y, letterbox_mode ? "letterbox" : "stretch");
+}
 
-    rknn_inputs_set(ctx, io_num.n_input, inputs);  // 设置输入数据
+// 替换输入槽的缓冲区：槽的图像只是缓冲区的视图，不拥有内存；画布内容随缓冲区一起失效，下次使用时重新填充
+void RkPt::set_input_memory(int slot, TensorMemory *mem)
+{
+    release_input_memory(slot);
+    input_slots[slot].mem = mem;
+    input_slots[slot].img = cv::Mat(height, width, CV_8UC3, mem->data(), mem->row_stride());
+    input_slots[slot].canvas_valid = false;
+    if (bound_slot == slot)
+        bound_slot = -1;
+}
 
-    rknn_output outputs[io_num.n_output];
-    memset(outputs, 0, sizeof(outputs));  // 初始化输出结构体
-    for (int i = 0; i < io_num.n_output; i++)
+void RkPt::release_input_memory(int slot)
+{
+    InputSlot &s = input_slots[slot];
+    s.img.release();
+    if (s.rga_handle != 0)
     {
-        outputs[i].want_float = 0;  // 设置不需要浮点输出
-        outputs[i].is_prealloc = 0;  // 设置不预分配内存
-        outputs[i].index = i;  // 设置输出索引
+        releasebuffer_handle(s.rga_handle);
+        s.rga_handle = 0;
+    }
+    if (s.mem)
+    {
+        delete s.mem;
+        s.mem = NULL;
+    }
+}
+
+// 开启零拷贝输入：每个输入槽分配一块NPU输入内存，再把它的fd导入RGA；导入失败时RGA按虚拟地址写入，
+// 仍然免去推理时的拷贝。推理时只重新绑定当前槽的内存
+int RkPt::enable_zero_copy_input()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (input_slots[0].mem && input_slots[0].mem->bound())
+        return 0;
+    if (!input_attrs || num_jobs != 0)
+    {
+        printf("zero copy input needs an initialized, idle model\n");
+        return -1;
+    }
+    NpuTensorMemory *mems[INFER_SLOTS];
+    for (int i = 0; i < INFER_SLOTS; i++)
+    {
+        rknn_tensor_attr attr = input_attrs[0];
+        mems[i] = NpuTensorMemory::create(ctx, &attr, width, height, channel);
+        if (mems[i] == NULL)
+        {
+            for (int j = 0; j < i; j++)
+                delete mems[j];
+            return -1;
+        }
+    }
+    for (int i = 0; i < INFER_SLOTS; i++)
+    {
+        set_input_memory(i, mems[i]);
+        if (mems[i]->fd() >= 0 && mems[i]->offset() == 0)
+            input_slots[i].rga_handle = importbuffer_fd(mems[i]->fd(), (int)mems[i]->size());
+        if (input_slots[i].rga_handle == 0)
+            printf("rga importbuffer_fd failed, rga writes input %d by virtual address\n", i);
     }
+    bound_slot = -1;  // 最后创建的内存处于绑定状态，第一次推理时按槽重新绑定
+    printf("zero copy input enabled, size %u, row stride %d\n", mems[0]->size(), mems[0]->row_stride());
+    return 0;
+}
 
-    struct timeval start_time, stop_time;
-    gettimeofday(&start_time, NULL);  // 记录开始时间
-    ret = rknn_run(ctx, nullptr);  // 运行模型推理
-    ret = rknn_outputs_get(ctx, io_num.n_output, outputs, NULL);  // 获取输出结果
-    gettimeofday(&stop_time, NULL);  // 记录结束时间
-    // printf("once run use %f ms\n", (__get_us(stop_time) - __get_us(start_time)) / 1000);
+// 设置静态忽略区域，清除旧位图，下一帧推理时按图像尺寸重建
+void RkPt::set_ignore_regions(const IgnoreRegions &regions)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    ignore_regions = regions;
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+        pp_config.cell_masks[h] = NULL;
+    ignore_img_width = -1;
+    ignore_img_height = -1;
+}
 
-    // 后处理
-    DetectResultsGroup det_result;
-    std::vector<int32_t> qnt_zps;  // 量化零点
-    std::vector<float> qnt_scales;  // 量化尺度
+// 设置参与解码的类别：不在列表中的类别不参与argmax，不会产生候选，也不参与NMS
+int RkPt::set_active_classes(const std::vector<int> &class_ids)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::vector<uint8_t> ids;
+    for (int id : class_ids)
+    {
+        if (id < 0 || id >= decode_layout.num_classes)
+        {
+            printf("active class id %d out of range [0, %d)\n", id, decode_layout.num_classes);
+            return -1;
+        }
+        ids.push_back((uint8_t)id);
+    }
+    std::sort(ids.begin(), ids.end());  // 升序，相同得分时保留下标较小的类别，与全部类别时一致
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    active_classes = ids;
+    if (active_classes.empty() || (int)active_classes.size() == decode_layout.num_classes)
+    {
+        pp_config.active_classes = NULL;
+        pp_config.num_active_classes = 0;
+    }
+    else
+    {
+        pp_config.active_classes = active_classes.data();
+        pp_config.num_active_classes = (int)active_classes.size();
+    }
+    return 0;
+}
+
+// 开启NPU原生布局输出：查询原生输出属性，为每个输出分配NPU内存并用rknn_set_io_mem绑定，
+// 推理后直接在原生布局上解码，不再由rknn_outputs_get把输出转换为NCHW
+int RkPt::enable_native_output()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (native_output)
+        return 0;
+    if (!output_attrs || output_mems || num_jobs != 0)
+    {
+        printf("native output needs an initialized, idle model\n");
+        return -1;
+    }
+
+    // 先查询并检查全部输出的原生属性，都能解码时才分配和绑定内存
+    rknn_tensor_attr *native_attrs = (rknn_tensor_attr *)calloc(io_num.n_output, sizeof(rknn_tensor_attr));
+    DecodeLayout layout = decode_layout;
+    for (int i = 0; i < io_num.n_output; i++)
+    {
+        native_attrs[i].index = i;
+        // 优先NHWC（每个网格单元的通道全部连续），不支持时取默认原生布局（RK3588上为NC1HWC2）
+        ret = rknn_query(ctx, RKNN_QUERY_NATIVE_NHWC_OUTPUT_ATTR, &(native_attrs[i]), sizeof(rknn_tensor_attr));
+        if (ret < 0)
+            ret = rknn_query(ctx, RKNN_QUERY_NATIVE_OUTPUT_ATTR, &(native_attrs[i]), sizeof(rknn_tensor_attr));
+        if (ret < 0)
+        {
+            printf("query native output %d attr error ret=%d\n", i, ret);
+            free(native_attrs);
+            return -1;
+        }
+        dump_tensor_attr(&(native_attrs[i]));
+        if (i >= OBJ_HEAD_NUM)
+            continue;
+
+        rknn_tensor_attr &attr = native_attrs[i];
+        int grid_h, grid_w, fmt, cell_step;
+        if (attr.fmt == RKNN_TENSOR_NHWC && attr.n_dims == 4)
+        {
+            grid_h = attr.dims[1];
+            grid_w = attr.dims[2];
+            fmt = OUTPUT_NHWC;
+            cell_step = attr.dims[3];
+            // 通道按对齐填充时，每个网格单元的实际通道数由带填充的大小得到
+            if (attr.size_with_stride > attr.size && attr.size_with_stride % (grid_h * grid_w) == 0)
+                cell_step = attr.size_with_stride / (grid_h * grid_w);
+        }
+        else if (attr.fmt == RKNN_TENSOR_NC1HWC2 && attr.n_dims == 5)
+        {
+            grid_h = attr.dims[2];
+            grid_w = attr.dims[3];
+            fmt = OUTPUT_NC1HWC2;
+            cell_step = attr.dims[4];
+        }
+        else
+        {
+            printf("native output %d fmt %s is not supported\n", i, get_format_string(attr.fmt));
+            free(native_attrs);
+            return -1;
+        }
+        if (attr.type != RKNN_TENSOR_INT8 || grid_h != layout.grid_h[i] || grid_w != layout.grid_w[i] ||
+            set_head_format(&layout, i, fmt, cell_step) < 0)
+        {
+            printf("native output %d does not match output layout\n", i);
+            free(native_attrs);
+            return -1;
+        }
+    }
 
+    int num_bound = 0;  // 已用rknn_set_io_mem绑定的输出数
+    output_mems = (rknn_tensor_mem **)calloc(io_num.n_output, sizeof(rknn_tensor_mem *));
     for (int i = 0; i < io_num.n_output; i++)
     {
-        if (output_attrs[i].qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC || output_attrs[i].qnt_type == RKNN_TENSOR_QNT_DFP)
+        output_mems[i] = rknn_create_mem(ctx, native_attrs[i].size_with_stride);
+        if (output_mems[i] == NULL)
+        {
+            printf("rknn_create_mem for output %d failed\n", i);
+            break;
+        }
+        ret = rknn_set_io_mem(ctx, output_mems[i], &(native_attrs[i]));
+        if (ret < 0)
         {
-            if (output_attrs[i].type == RKNN_TENSOR_INT8 || output_attrs[i].type == RKNN_TENSOR_UINT8)
-            {
-                qnt_zps.push_back(output_attrs[i].zp);  // 添加量化零点
-                qnt_scales.push_back(output_attrs[i].scale);  // 添加量化尺度
-            }
+            printf("rknn_set_io_mem for output %d error ret=%d\n", i, ret);
+            break;
         }
+        num_bound++;
+    }
+    free(native_attrs);
+    if (num_bound < io_num.n_output)
+    {
+        // 释放已创建的内存；rknn_api没有解除输出绑定的接口，已有输出绑定到原生布局时无法恢复NCHW输出，
+        // 内存释放后NPU仍会写入，所以该上下文不再接受任务
+        for (int i = 0; i < io_num.n_output; i++)
+        {
+            if (output_mems[i])
+                rknn_destroy_mem(ctx, output_mems[i]);
+        }
+        free(output_mems);
+        output_mems = NULL;
+        if (num_bound > 0)
+        {
+            broken = true;
+            printf("native output partially bound, context disabled\n");
+            return -2;
+        }
+        printf("native output disabled\n");
+        return -1;
     }
 
-    ret = post_process((int8_t *)outputs[0].buf, (int8_t *)outputs[1].buf, (int8_t *)outputs[2].buf, height, width,
-                       box_conf_threshold, nms_threshold, pads, scale_w, scale_h, qnt_zps, qnt_scales, &det_result);  // 后处理
-                       
-    // 设置结果的当前帧ID和图像
-    det_result.cur_frame_id = cur_frame_id;
-    det_result.cur_img = orig_img.clone();
-    
+    // 之后不再调用rknn_outputs_get，释放预分配的NCHW输出缓冲区
+    for (int i = 0; i < io_num.n_output; i++)
+        free(outputs[i].buf);
+    free(outputs);
+    outputs = NULL;
+
+    decode_layout = layout;
+    native_output = true;
+    printf("native output enabled, fmt: %s %s %s\n", get_format_string((rknn_tensor_format)layout.fmt[0]),
+           get_format_string((rknn_tensor_format)layout.fmt[1]), get_format_string((rknn_tensor_format)layout.fmt[2]));
+    return 0;
+}
+
+// 获取RKNN上下文
+rknn_context *RkPt::get_pctx()
+{
+    return &ctx;
+}
+
+// 把帧写入输入槽：一次RGA任务完成BGR→RGB和缩放，直接写入图像区域；RGA失败后该上下文改由CPU处理
+void RkPt::preprocess(const cv::Mat &orig_img, InputSlot &slot)
+{
+    if (letterbox_mode && !slot.canvas_valid)
+    {
+        slot.img.setTo(cv::Scalar(128, 128, 128));  // 填充色与letterbox()默认值一致，每个槽在几何变化后只填充一次
+        slot.canvas_valid = true;
+    }
+    if (!use_rga || convert_resize_rga(orig_img, slot.img, input_rect, slot.rga_handle) != 0)
+    {
+        if (use_rga)
+        {
+            printf("rga preprocess failed, fall back to cpu\n");
+            use_rga = false;
+        }
+        convert_resize_cpu(orig_img, slot.img, input_rect);
+    }
+}
+
+// 设置输入并以非阻塞方式启动推理：NPU内存输入只在换槽时重新绑定，主机内存输入由rknn_inputs_set拷贝
+int RkPt::launch(InferJob &job)
+{
+    InputSlot &slot = input_slots[job.slot];
+    if (slot.mem->bound())
+    {
+        if (bound_slot != job.slot)
+        {
+            if (slot.mem->bind() != 0)
+                return -1;
+            bound_slot = job.slot;
+        }
+    }
+    else
+    {
+        inputs[0].buf = slot.img.data;  // 设置输入数据缓冲区
+        ret = rknn_inputs_set(ctx, io_num.n_input, inputs);  // 设置输入数据
+        if (ret < 0)
+        {
+            printf("rknn_inputs_set error ret=%d\n", ret);
+            return -1;
+        }
+    }
+    memset(&run_ext, 0, sizeof(run_ext));
+    run_ext.non_block = 1;  // 立即返回，由rknn_wait等待完成
+    ret = rknn_run(ctx, &run_ext);
+    if (ret < 0)
+    {
+        printf("rknn_run error ret=%d\n", ret);
+        return -1;
+    }
+    job.state = JOB_RUNNING;
+    return 0;
+}
+
+// 启动排队中最早的任务，失败的任务在wait时返回-1
+void RkPt::launch_queued()
+{
+    if (num_jobs > 0 && jobs[0].state == JOB_QUEUED && launch(jobs[0]) != 0)
+        jobs[0].state = JOB_FAILED;
+}
+
+// 等待NPU完成并取回输出：NCHW输出由rknn_outputs_get写入预分配的缓冲区，原生布局输出已在绑定的内存中
+int RkPt::collect(InferJob &job)
+{
+    if (job.state == JOB_RUNNING)
+    {
+        ret = rknn_wait(ctx, &run_ext);
+        if (ret < 0)
+        {
+            printf("rknn_wait error ret=%d\n", ret);
+            return -1;
+        }
+        job.state = JOB_DONE;
+    }
+    if (job.state != JOB_DONE)
+        return -1;
+    if (!native_output)
+    {
+        ret = rknn_outputs_get(ctx, io_num.n_output, outputs, NULL);  // 输出写入预分配的缓冲区
+        if (ret < 0)
+        {
+            printf("rknn_outputs_get error ret=%d\n", ret);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 在取回的输出上后处理，使用任务提交时的填充和缩放比例
+void RkPt::decode(const InferJob &job, DetectResultsGroup &result)
+{
+    int frame_width = job.frame->img.cols;
+    int frame_height = job.frame->img.rows;
+    // 忽略区域位图只与图像尺寸（以及由此确定的缩放比例和填充）有关，尺寸变化时才重建
+    if ((!ignore_regions.rects.empty() || !ignore_regions.polygons.empty()) &&
+        (frame_width != ignore_img_width || frame_height != ignore_img_height))
+    {
+        int ignored = build_ignore_masks(&ignore_regions, &decode_layout, job.pads, job.scale_w, job.scale_h, ignore_masks);
+        for (int h = 0; h < OBJ_HEAD_NUM; h++)
+            pp_config.cell_masks[h] = ignore_masks[h].data();
+        ignore_img_width = frame_width;
+        ignore_img_height = frame_height;
+        printf("ignore mask rebuilt for %dx%d image, %d cells ignored\n", frame_width, frame_height, ignored);
+    }
+
+    int8_t *heads[OBJ_HEAD_NUM];
+    for (int i = 0; i < OBJ_HEAD_NUM; i++)
+    {
+        // 原生布局输出直接在绑定的内存上解码，不做布局转换
+        if (native_output)
+            heads[i] = (int8_t *)output_mems[i]->virt_addr;
+        else
+            heads[i] = (int8_t *)outputs[i].buf;
+    }
+
+    // 后处理（量化参数和置信度阈值已包含在查找表中）
+    ret = post_process(heads[0], heads[1], heads[2], height, width,
+                       &pp_config, job.pads, job.scale_w, job.scale_h, &decode_layout, quant_tables,
+                       &pp_workspace, &result);  // 后处理
+
     // 设置每个检测框的模型类型
-    for (auto &det : det_result.dets) {
+    for (auto &det : result.dets) {
         det.model_type = this->model_type;
     }
+}
+
+// 选择新任务的输入槽：优先复用当前绑定的槽，NPU内存输入逐帧串行时不必每帧重新绑定；
+// 只有该槽仍被未取回的任务占用（另一个任务还在进行）时才换到空闲的槽
+int RkPt::pick_slot() const
+{
+    int preferred = bound_slot >= 0 ? bound_slot : 0;
+    for (int k = 0; k < INFER_SLOTS; k++)
+    {
+        int slot = (preferred + k) % INFER_SLOTS;
+        bool busy = false;
+        for (int i = 0; i < num_jobs; i++)
+        {
+            if (jobs[i].slot == slot)
+                busy = true;
+        }
+        if (!busy)
+            return slot;
+    }
+    return -1;
+}
+
+// 提交任务：计算输入几何、预处理到空闲的输入槽；前面没有任务时立即启动，否则等前一个任务取回输出后由wait启动
+int RkPt::submit_locked(const FramePtr &frame, int frame_id)
+{
+    if (broken)
+    {
+        printf("submit failed, context disabled\n");
+        return -1;
+    }
+    if (num_jobs >= INFER_SLOTS)
+    {
+        printf("submit failed, %d jobs pending\n", num_jobs);
+        return -1;
+    }
+    const cv::Mat &orig_img = frame->img;
+    img_width = orig_img.cols;  // 获取图像宽度
+    img_height = orig_img.rows;  // 获取图像高度
+
+    // 缩放比例、填充和图像区域只与图像尺寸有关，尺寸变化时才重新计算
+    if (img_width != geom_img_width || img_height != geom_img_height)
+        update_input_geometry();
+
+    InferJob &job = jobs[num_jobs];
+    job.frame = frame;  // 共享输入帧，不复制
+    job.frame_id = frame_id;
+    job.slot = pick_slot();
+    job.state = JOB_QUEUED;
+    job.pads = input_pads;
+    job.scale_w = input_scale_w;
+    job.scale_h = input_scale_h;
+    num_jobs++;
+
+    preprocess(orig_img, input_slots[job.slot]);  // 前一个任务在NPU上运行时与之并行
+    if (num_jobs == 1)
+        launch_queued();
+    return 0;
+}
 
-    ret = rknn_outputs_release(ctx, io_num.n_output, outputs);  // 释放输出结果
+// 取回最早的任务：NCHW输出已拷贝到预分配缓冲区，先启动排队的下一帧再解码，解码与NPU并行；
+// 原生布局输出由NPU直接写入绑定的内存，需解码完再启动下一帧
+int RkPt::wait_locked(DetectResultsGroup &result)
+{
+    if (num_jobs == 0)
+        return -1;
+    InferJob job = jobs[0];
+    int status = collect(job);
+    for (int i = 1; i < num_jobs; i++)
+        jobs[i - 1] = jobs[i];
+    num_jobs--;
+    jobs[num_jobs].frame.reset();
+
+    result.cur_frame_id = job.frame_id;  // 设置结果的当前帧ID和图像
+    result.cur_frame = job.frame;
+    result.dets.clear();
+    if (!native_output)
+        launch_queued();
+    if (status == 0)
+        decode(job, result);
+    if (native_output)
+        launch_queued();
+    return status;
+}
+
+int RkPt::submit(const FramePtr &frame, int frame_id)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return submit_locked(frame, frame_id);
+}
+
+// 查询最早的任务是否完成：rknn_wait最多等待1ms，完成后记录状态，wait不再等待
+int RkPt::poll()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (num_jobs == 0)
+        return -1;
+    InferJob &job = jobs[0];
+    if (job.state != JOB_RUNNING)
+        return 1;  // 已完成或出错，wait立即返回
+    rknn_run_extend ext = run_ext;
+    ext.timeout_ms = 1;
+    ret = rknn_wait(ctx, &ext);
+    if (ret == RKNN_ERR_TIMEOUT)
+        return 0;
+    if (ret < 0)
+        printf("rknn_wait error ret=%d\n", ret);
+    job.state = ret < 0 ? JOB_FAILED : JOB_DONE;
+    return 1;
+}
 
+int RkPt::wait(DetectResultsGroup &result)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return wait_locked(result);
+}
+
+// 阻塞推理：在同一把锁内提交并取回，帧数据只读共享，颜色转换只在模型输入尺寸的缓冲区上进行，不复制整帧
+DetectResultsGroup RkPt::infer(const FramePtr &frame, int cur_frame_id)
+{
+    std::lock_guard<std::mutex> lock(mtx);  // 加锁，确保线程安全
+    DetectResultsGroup det_result;
+    det_result.cur_frame_id = cur_frame_id;
+    det_result.cur_frame = frame;
+    if (num_jobs != 0)
+    {
+        printf("infer called with %d async jobs pending\n", num_jobs);
+        return det_result;
+    }
+    if (submit_locked(frame, cur_frame_id) == 0)
+        wait_locked(det_result);
     return det_result;  // 返回检测结果
 }
 
 // RKPT类析构函数
 RkPt::~RkPt()
 {
+    if (num_jobs > 0 && jobs[0].state == JOB_RUNNING)
+        rknn_wait(ctx, &run_ext);  // 等待未取回的推理结束再释放内存
+    if (output_mems)
+    {
+        for (int i = 0; i < io_num.n_output; i++)
+        {
+            if (output_mems[i])
+                rknn_destroy_mem(ctx, output_mems[i]);  // 释放原生布局输出内存
+        }
+        free(output_mems);
+    }
+    if (outputs)
+    {
+        for (int i = 0; i < io_num.n_output; i++)
+            free(outputs[i].buf);  // 释放预分配的输出缓冲区
+        free(outputs);
+    }
+    for (int i = 0; i < INFER_SLOTS; i++)
+        release_input_memory(i);  // 输入内存需在销毁上下文之前释放
     ret = rknn_destroy(ctx);  // 销毁RKNN上下文
 
-    if (model_data)
-        free(model_data);  // 释放模型数据
-
     if (input_attrs)
         free(input_attrs);  // 释放输入属性
     if (output_attrs)
         free(output_attrs);  // 释放输出属性
+    release_postprocess_workspace(&pp_workspace);  // 释放后处理工作区
 }
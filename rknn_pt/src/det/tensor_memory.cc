@@ -0,0 +1,52 @@
+#include <stdio.h>
+
+#include "rknn_api.h"
+#include "tensor_memory.h"
+
+//分配NPU可直接访问的输入内存并绑定到模型输入，只在初始化时调用一次；
+//输入按NHWC、UINT8绑定，宽度方向有对齐要求时每行按w_stride存放
+NpuTensorMemory *NpuTensorMemory::create(rknn_context ctx, rknn_tensor_attr *attr, int width, int height, int channel)
+{
+    attr->type = RKNN_TENSOR_UINT8;
+    attr->fmt = RKNN_TENSOR_NHWC;
+    attr->pass_through = 0;
+    int w_stride = (int)attr->w_stride > width ? (int)attr->w_stride : width;
+    uint32_t size = attr->size_with_stride > 0 ? attr->size_with_stride : (uint32_t)(w_stride * height * channel);
+    if (size < (uint32_t)(w_stride * height * channel))
+    {
+        printf("input size_with_stride %u is smaller than %dx%dx%d\n", attr->size_with_stride, w_stride, height, channel);
+        return NULL;
+    }
+
+    rknn_tensor_mem *mem = rknn_create_mem(ctx, size);
+    if (mem == NULL)
+    {
+        printf("rknn_create_mem for input failed\n");
+        return NULL;
+    }
+    int ret = rknn_set_io_mem(ctx, mem, attr);
+    if (ret < 0)
+    {
+        printf("rknn_set_io_mem for input error ret=%d\n", ret);
+        rknn_destroy_mem(ctx, mem);
+        return NULL;
+    }
+    return new NpuTensorMemory(ctx, mem, *attr, w_stride * channel);
+}
+
+//重新绑定为模型输入，只改变NPU读取的地址，不拷贝数据
+int NpuTensorMemory::bind()
+{
+    int ret = rknn_set_io_mem(ctx, mem, &attr);
+    if (ret < 0)
+    {
+        printf("rknn_set_io_mem for input error ret=%d\n", ret);
+        return -1;
+    }
+    return 0;
+}
+
+NpuTensorMemory::~NpuTensorMemory()
+{
+    rknn_destroy_mem(ctx, mem);
+}
@@ -10,6 +10,9 @@
 #include <queue>         // 支持std::queue，用于FPS计算
 #include <chrono>        // 支持时间计算，用于FPS
 #include <mutex>
+#include <thread>
+#include <future>        // 两个模型池并行初始化
+#include <atomic>        // 相机帧号计数
 
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
@@ -24,9 +27,12 @@
 
 #include "rkpt.hpp"
 #include "rknnPool.hpp"
+
+static_assert(CONTEXT_JOBS <= INFER_SLOTS, "rknnPool queues more jobs per context than RkPt has input slots");
 #include "rknn_pt/ObjectDetection.h" // 加入新的消息头文件
+#include "rknn_pt/SetActiveClasses.h" // 设置参与解码类别的服务
 
-// ModelType 枚举已在 rkpt.hpp 中定义，不需要重复定义
+// ModelType 枚举已在 common.h 中定义，不需要重复定义
 
 // 物体和数字识别的类别数量定义
 #define OBJ_MATERIAL_CLASS_NUM 15 // 物资类别数量
@@ -50,15 +56,23 @@ const std::string digit_labels[OBJ_DIGIT_CLASS_NUM] = {
 };
 
 // 全局变量
-cv::Mat ros_frame;
+FramePtr ros_frame;  // 最新一帧的只读句柄
 std::mutex frame_mutex;
 ros::Publisher det_pub;
 int isInPoint = 0;  // 0表示未到达指定位置，1表示已到达指定位置
-int cur_frame_id = 0;
-rknnPool<RkPt, cv::Mat, DetectResultsGroup> *detectPoolObj = nullptr;
-rknnPool<RkPt, cv::Mat, DetectResultsGroup> *detectPoolNum = nullptr;
+int cur_frame_id = 0;  // 主循环计数，用于定期输出统计
+std::atomic<int> image_frame_id(0);  // 相机帧号：每个图像回调取一个新值，同一次spinOnce中的多帧也不会重复
+rknnPool<RkPt, FramePtr, DetectResultsGroup> *detectPoolObj = nullptr;
+rknnPool<RkPt, FramePtr, DetectResultsGroup> *detectPoolNum = nullptr;
+dpool::ThreadPool *decodePool = nullptr;  // 两个模型共享的帧内并行解码线程池，需在模型池之后释放
 bool hasObjectDetected = false;  // 用于标记是否检测到物体
 
+// 结果显示相关变量（结果回调在工作线程中执行，显示统一放到主线程）
+cv::Mat display_frame;
+std::mutex display_mutex;
+bool has_new_display = false;
+bool show_image = true;  // 是否显示结果图像，关闭后不再为绘制复制帧
+
 // FPS计算相关变量
 std::queue<double> frame_times;
 double fps = 0.0;
@@ -361,6 +375,213 @@ void drawCombinedDigits(cv::Mat& img, const std::vector<DetectionBox>& detection
                 cv::Scalar(0, 0, 0), thickness);
 }
 
+/**
+ * 读取XmlRpc数值（参数里的整数和小数都接受）
+ */
+static bool xmlRpcToDouble(XmlRpc::XmlRpcValue &value, double &out) {
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt) {
+    out = (double)(int)value;
+    return true;
+  }
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeDouble) {
+    out = (double)value;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * 从参数服务器读取静态忽略区域（原图坐标）
+ * 优先读取模型专属的 <prefix>ignore_rects / <prefix>ignore_polygons，没有时使用两个模型共用的 ignore_rects / ignore_polygons
+ * ignore_rects: [[x, y, w, h], ...]；ignore_polygons: [[x1, y1, x2, y2, x3, y3, ...], ...]
+ * @param nh 节点句柄
+ * @param prefix 模型参数前缀（"obj_" 或 "num_"）
+ * @param regions 输出的忽略区域
+ */
+void loadIgnoreRegions(ros::NodeHandle &nh, const std::string &prefix, IgnoreRegions &regions) {
+  XmlRpc::XmlRpcValue rects, polygons;
+  if (nh.getParam(prefix + "ignore_rects", rects) || nh.getParam("ignore_rects", rects)) {
+    if (rects.getType() == XmlRpc::XmlRpcValue::TypeArray) {
+      for (int i = 0; i < rects.size(); i++) {
+        double v[4];
+        if (rects[i].getType() != XmlRpc::XmlRpcValue::TypeArray || rects[i].size() != 4 ||
+            !xmlRpcToDouble(rects[i][0], v[0]) || !xmlRpcToDouble(rects[i][1], v[1]) ||
+            !xmlRpcToDouble(rects[i][2], v[2]) || !xmlRpcToDouble(rects[i][3], v[3])) {
+          ROS_WARN("%signore_rects[%d] should be [x, y, w, h], skipped", prefix.c_str(), i);
+          continue;
+        }
+        regions.rects.push_back(cv::Rect_<float>(v[0], v[1], v[2], v[3]));
+      }
+    }
+  }
+  if (nh.getParam(prefix + "ignore_polygons", polygons) || nh.getParam("ignore_polygons", polygons)) {
+    if (polygons.getType() == XmlRpc::XmlRpcValue::TypeArray) {
+      for (int i = 0; i < polygons.size(); i++) {
+        XmlRpc::XmlRpcValue &poly = polygons[i];
+        if (poly.getType() != XmlRpc::XmlRpcValue::TypeArray || poly.size() < 6 || poly.size() % 2 != 0) {
+          ROS_WARN("%signore_polygons[%d] should be [x1, y1, x2, y2, x3, y3, ...], skipped", prefix.c_str(), i);
+          continue;
+        }
+        std::vector<cv::Point2f> points;
+        for (int k = 0; k + 1 < poly.size(); k += 2) {
+          double x, y;
+          if (!xmlRpcToDouble(poly[k], x) || !xmlRpcToDouble(poly[k + 1], y)) {
+            points.clear();
+            break;
+          }
+          points.push_back(cv::Point2f(x, y));
+        }
+        if (points.empty()) {
+          ROS_WARN("%signore_polygons[%d] has non-numeric vertex, skipped", prefix.c_str(), i);
+          continue;
+        }
+        regions.polygons.push_back(points);
+      }
+    }
+  }
+  ROS_INFO("%sdetection ignore regions: %zu rects, %zu polygons", prefix.c_str(), regions.rects.size(),
+           regions.polygons.size());
+}
+
+/**
+ * 把类别名称转换为模型内的类别下标
+ * @param model 模型名称（"obj" 或 "num"）
+ * @param name 类别名称
+ * @return 类别下标，找不到时返回-1
+ */
+int classIdFromName(const std::string &model, const std::string &name) {
+  const std::string *labels = (model == "num") ? digit_labels : material_labels;
+  int num = (model == "num") ? OBJ_DIGIT_CLASS_NUM : OBJ_MATERIAL_CLASS_NUM;
+  for (int i = 0; i < num; i++) {
+    if (labels[i] == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * 设置模型池所有上下文参与解码的类别
+ * @param model 模型名称（"obj" 或 "num"）
+ * @param class_ids 类别下标，为空时恢复全部类别
+ * @param message 输出的结果说明
+ * @return 是否设置成功
+ */
+bool applyActiveClasses(const std::string &model, const std::vector<int> &class_ids, std::string &message) {
+  rknnPool<RkPt, FramePtr, DetectResultsGroup> *pool = nullptr;
+  if (model == "obj") {
+    pool = detectPoolObj;
+  } else if (model == "num") {
+    pool = detectPoolNum;
+  }
+  if (pool == nullptr) {
+    message = "unknown model: " + model;
+    return false;
+  }
+
+  int failed = 0;
+  pool->for_each_model([&](RkPt *m) {
+    if (m->set_active_classes(class_ids) != 0) {
+      failed++;
+    }
+  });
+  if (failed > 0) {
+    message = "class id out of range for model " + model;
+    return false;
+  }
+
+  message = class_ids.empty() ? "all classes active" : std::to_string(class_ids.size()) + " classes active";
+  ROS_INFO("%s model: %s", model.c_str(), message.c_str());
+  return true;
+}
+
+/**
+ * 从参数服务器读取模型启动时参与解码的类别 <model>_active_classes，列表元素可以是类别下标或类别名称
+ * @param nh 节点句柄
+ * @param model 模型名称（"obj" 或 "num"）
+ * @param class_ids 输出的类别下标，参数不存在时为空（全部类别）
+ */
+void loadActiveClasses(ros::NodeHandle &nh, const std::string &model, std::vector<int> &class_ids) {
+  XmlRpc::XmlRpcValue classes;
+  if (!nh.getParam(model + "_active_classes", classes) || classes.getType() != XmlRpc::XmlRpcValue::TypeArray) {
+    return;
+  }
+  for (int i = 0; i < classes.size(); i++) {
+    if (classes[i].getType() == XmlRpc::XmlRpcValue::TypeInt) {
+      class_ids.push_back((int)classes[i]);
+    } else if (classes[i].getType() == XmlRpc::XmlRpcValue::TypeString) {
+      int id = classIdFromName(model, (std::string)classes[i]);
+      if (id < 0) {
+        ROS_WARN("%s_active_classes[%d]: unknown class name, skipped", model.c_str(), i);
+        continue;
+      }
+      class_ids.push_back(id);
+    } else {
+      ROS_WARN("%s_active_classes[%d] should be a class id or name, skipped", model.c_str(), i);
+    }
+  }
+}
+
+/**
+ * 设置当前任务阶段参与解码的类别的服务回调
+ */
+bool setActiveClassesCallback(rknn_pt::SetActiveClasses::Request &req, rknn_pt::SetActiveClasses::Response &res) {
+  std::vector<int> class_ids(req.class_ids.begin(), req.class_ids.end());
+  for (size_t i = 0; i < req.class_names.size(); i++) {
+    int id = classIdFromName(req.model, req.class_names[i]);
+    if (id < 0) {
+      res.success = false;
+      res.message = "unknown class name: " + req.class_names[i];
+      return true;
+    }
+    class_ids.push_back(id);
+  }
+  res.success = applyActiveClasses(req.model, class_ids, res.message);
+  return true;
+}
+
+/**
+ * 输出模型池中各上下文的排队时间和推理时间，用于检查负载是否均衡
+ * @param name 模型池名称
+ * @param pool 模型池
+ */
+void logContextStats(const char *name, rknnPool<RkPt, FramePtr, DetectResultsGroup> *pool) {
+  std::vector<ContextStats> ctx_stats = pool->get_context_stats();
+  for (size_t i = 0; i < ctx_stats.size(); i++) {
+    const ContextStats &cs = ctx_stats[i];
+    if (cs.frames == 0) {
+      ROS_INFO("%s context %zu: idle", name, i);
+      continue;
+    }
+    ROS_INFO("%s context %zu: frames=%lld, wait avg=%.2fms max=%.2fms, infer avg=%.2fms", name, i, cs.frames,
+             cs.waitMsTotal / cs.frames, cs.waitMsMax, cs.inferMsTotal / cs.frames);
+  }
+}
+
+/**
+ * 预热：每个上下文在合成帧上推理若干次，首帧的NPU内部缓冲区分配、输入几何计算等一次性开销在订阅相机前完成；
+ * 各上下文绑定不同的NPU核心，并行预热
+ * @param frames 每个上下文的预热次数
+ * @param width 合成帧宽度，与相机分辨率一致时输入几何无需在首帧重新计算
+ * @param height 合成帧高度
+ */
+void warmUpModels(int frames, int width, int height) {
+  FramePtr frame = make_frame(cv::Mat(height, width, CV_8UC3, cv::Scalar(0, 0, 0)));
+  std::vector<std::thread> workers;
+  auto warm_up = [&](RkPt *model) {
+    workers.emplace_back([model, frame, frames]() {
+      for (int i = 0; i < frames; i++) {
+        model->infer(frame, -1 - i);  // 预热帧号为负，不会与相机帧混淆
+      }
+    });
+  };
+  detectPoolObj->for_each_model(warm_up);
+  detectPoolNum->for_each_model(warm_up);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
 /**
  * MoveBase动作结果回调，用于更新isInPoint状态
  */
@@ -375,85 +596,136 @@ void moveBaseResultCallback(const move_base_msgs::MoveBaseActionResultConstPtr &
   }
 }
 
-// 图像回调函数，接收ROS图像并进行处理
-void imageCallback(const sensor_msgs::ImageConstPtr &msg)
-{
-  // 使用局部变量而不是全局变量，减少线程同步问题
-  cv::Mat local_frame;
-  cv::Mat display_img;
+/**
+ * 将绘制好的结果图像交给主线程显示（HighGUI只能在主线程中调用）
+ * @param img 结果图像
+ */
+void submitDisplay(cv::Mat &img) {
+  if (img.empty()) return;
   
-  try
+  // 在右上角显示FPS
+  displayFPS(img);
+  
+  std::lock_guard<std::mutex> lock(display_mutex);
+  display_frame = img;
+  has_new_display = true;
+}
+
+/**
+ * 在主线程中显示最新的结果图像
+ */
+void showLatestDisplay() {
+  cv::Mat img;
   {
-    // 首先尝试转换ROS图像为OpenCV格式
-    local_frame = cv_bridge::toCvShare(msg, "bgr8")->image;
-    if (local_frame.empty()) {
-      ROS_ERROR("Received empty image from camera");
-      return;
-    }
-    
-    // 使用clone创建独立副本，避免共享内存问题
-    display_img = local_frame.clone();
-    int width = display_img.cols;
-    int height = display_img.rows;
-    
-    // 检查模型指针
-    if (!detectPoolObj || !detectPoolNum) {
-      ROS_ERROR("Detection models not initialized properly");
-      return;
+    std::lock_guard<std::mutex> lock(display_mutex);
+    if (!has_new_display) return;
+    img = display_frame;
+    has_new_display = false;
+  }
+  
+  cv::imshow("Detection Results", img);
+  
+  // 按q键退出
+  int key = cv::waitKey(1);
+  if (key == 'q') {
+    ros::shutdown();
+  }
+}
+
+/**
+ * 数字识别结果回调，在数字模型池的工作线程中按帧序调用
+ * @param result_num 数字识别结果，cur_frame为与输入共享的只读帧
+ */
+void onNumberResult(DetectResultsGroup &result_num) {
+  std::lock_guard<std::mutex> lock(frame_mutex);
+  
+  // 帧数据只读共享，只有需要显示时才复制一份用于绘制
+  const cv::Mat &frame_img = result_num.cur_frame->img;
+  cv::Mat display_img;
+  if (show_image) {
+    display_img = frame_img.clone();
+  }
+  int width = frame_img.cols;
+  int height = frame_img.rows;
+  
+  // 处理数字识别结果
+  if (!result_num.dets.empty()) {
+    // 先过滤无效的检测框和置信度低的检测框
+    std::vector<DetectionBox> valid_dets;
+    for (auto &res : result_num.dets) {
+      // 只保留置信度大于等于0.65的检测框
+      if (res.score >= 0.65) {
+        
+        
+        // 为数字模型结果设置正确的类别名称
+        if (res.obj_id >= 0 && res.obj_id < OBJ_DIGIT_CLASS_NUM) {
+          res.det_name = digit_labels[res.obj_id];
+        } else {
+          ROS_WARN("Invalid digit ID: %d (max: %d)", res.obj_id, OBJ_DIGIT_CLASS_NUM - 1);
+          res.det_name = "unknown_digit";
+          continue; // 跳过无效数字
+        }
+        
+        if (res.box.width > 0 && res.box.height > 0 && 
+            res.box.x >= 0 && res.box.y >= 0 && 
+            res.box.x + res.box.width <= width && 
+            res.box.y + res.box.height <= height) {
+          valid_dets.push_back(res);
+        }
+      }
     }
     
-    // 互斥锁保护模型操作，避免并发问题
-    {
-      std::lock_guard<std::mutex> lock(frame_mutex);
-      
-      // 更新FPS计算
-      updateFPS();
-      
-      // 更新全局帧以供其他地方使用（如果需要）
-      ros_frame = local_frame.clone();
+    // 首先检查是否可以组合多位数
+    if (valid_dets.size() >= 2) {
+      // 尝试组合多位数
+      rknn_pt::ObjectDetection multi_digit_msg = processMultiDigitNumber(valid_dets, width, height);
       
-      // 调用物资识别模型，使用局部帧
-      detectPoolObj->put(display_img, cur_frame_id);
-      
-      // 获取物资识别结果
-      DetectResultsGroup result_obj;
-      detectPoolObj->get(result_obj);
-      
-      // 检查物资识别模型是否有结果
-      if (!result_obj.dets.empty()) {
-        // 物资识别模型有结果，处理结果
-        hasObjectDetected = false;  // 先重置检测标志
+      // 如果成功组合，发布组合后的结果
+      if (!multi_digit_msg.object_type.empty()) {
+        multi_digit_msg.is_in_position = isInPoint;  // 添加位置信息
+        det_pub.publish(multi_digit_msg);
         
-        // 过滤置信度低于0.65的检测框
-        std::vector<DetectionBox> valid_material_dets;
-        for (auto &res : result_obj.dets) {
-          // 只保留置信度大于等于0.65的检测框
-          if (res.score >= 0.65) {
-            // 检查检测框是否有效
-            if (res.box.width <= 0 || res.box.height <= 0 || 
-                res.box.x < 0 || res.box.y < 0 || 
-                res.box.x + res.box.width > width || 
-                res.box.y + res.box.height > height) {
-              continue;
-            }
-            
-            
-            
-            // 为物资模型结果设置正确的类别名称
-            if (res.obj_id >= 0 && res.obj_id < OBJ_MATERIAL_CLASS_NUM) {
-              res.det_name = material_labels[res.obj_id];
-            } else {
-              ROS_WARN("Invalid material ID: %d (max: %d)", res.obj_id, OBJ_MATERIAL_CLASS_NUM - 1);
-              res.det_name = "unknown_material";
+        // 检查是否所有检测都是数字
+        bool all_are_digits = true;
+        int combined_value = 0;
+        std::vector<DetectionBox> digit_dets;
+        
+        for (const auto &res : valid_dets) {
+          // 查找数字对应的值
+          const std::string &name = res.det_name;
+          auto it = digit_map.find(name);
+          if (it != digit_map.end()) {
+            digit_dets.push_back(res);
+          } else {
+            all_are_digits = false;
+            break;
+          }
+        }
+        
+        if (all_are_digits && digit_dets.size() >= 2) {
+          // 计算组合值
+          std::vector<DetectionBox> sorted_detections = digit_dets;
+          std::sort(sorted_detections.begin(), sorted_detections.end(), 
+              [](const DetectionBox& a, const DetectionBox& b) {
+                  return a.box.x < b.box.x;
+              });
+          
+          for (const auto& det : sorted_detections) {
+            auto it = digit_map.find(det.det_name);
+            if (it != digit_map.end()) {
+                int digit_value = it->second;
+                combined_value = combined_value * 10 + digit_value;
             }
-            
-            valid_material_dets.push_back(res);
-            hasObjectDetected = true;  // 有有效的物体检测
           }
+          
+          // 绘制组合数字
+          drawCombinedDigits(display_img, digit_dets, combined_value);
         }
+      } else {
+        // 如果无法组合，按单个数字处理
+        enhancedDrawDetections(display_img, valid_dets);
         
-        // 处理有效的物资检测结果
-        for (auto &res : valid_material_dets) {
+        for (const auto &res : valid_dets) {
           // 计算中心坐标
           int center_x = res.box.x + res.box.width / 2;
           int center_y = res.box.y + res.box.height / 2;
@@ -473,178 +745,186 @@ void imageCallback(const sensor_msgs::ImageConstPtr &msg)
           // 发布消息
           det_pub.publish(det_msg);
           
-          ROS_INFO("Detected object: %s (id: %d) at [%d, %d] with confidence %.2f, isInPoint: %d", 
+          ROS_INFO("Detected number: %s (id: %d) at [%d, %d] with confidence %.2f, isInPoint: %d", 
                    res.det_name.c_str(), res.obj_id, offset_center_x, offset_center_y, res.score, isInPoint);
         }
-        
-        // 绘制物资检测结果
-        enhancedDrawDetections(display_img, valid_material_dets);
-      } else {
-        // 物资识别模型无结果
-        hasObjectDetected = false;  // 标记未检测到物体
-        
-        // 仅当到达指定位置并且未检测到物体时才切换到数字识别模型
-        if (isInPoint == 1) {
-          ROS_INFO("已到达指定位置，且未检测到物体，切换到数字识别模型");
+      }
+    } else if (valid_dets.size() == 1) {
+      // 单个数字处理
+      enhancedDrawDetections(display_img, valid_dets);
+      
+      const auto &res = valid_dets[0];
+      // 计算中心坐标
+      int center_x = res.box.x + res.box.width / 2;
+      int center_y = res.box.y + res.box.height / 2;
+      
+      // 计算相对于图像中心的偏移
+      int offset_center_x = center_x - width / 2;
+      int offset_center_y = center_y - height / 2;
+      
+      // 创建检测消息
+      rknn_pt::ObjectDetection det_msg;
+      det_msg.object_type = res.det_name;
+      det_msg.center_x = offset_center_x;
+      det_msg.center_y = offset_center_y;
+      det_msg.confidence = res.score;
+      det_msg.is_in_position = isInPoint;  // 添加位置信息
+      
+      // 发布消息
+      det_pub.publish(det_msg);
+      
+      ROS_INFO("Detected number: %s (id: %d) at [%d, %d] with confidence %.2f, isInPoint: %d", 
+               res.det_name.c_str(), res.obj_id, offset_center_x, offset_center_y, res.score, isInPoint);
+    } else {
+      ROS_INFO("No valid digit detections");
+    }
+  } else {
+    ROS_INFO("No numbers detected");
+  }
+  
+  submitDisplay(display_img);
+}
+
+/**
+ * 物资识别结果回调，在物资模型池的工作线程中按帧序调用
+ * 未检测到物资且已到达指定位置时，把同一帧转交给数字识别模型池
+ * @param result_obj 物资识别结果，cur_frame为与输入共享的只读帧
+ */
+void onObjectResult(DetectResultsGroup &result_obj) {
+  bool need_number = false;  // 是否需要转交数字识别模型
+  
+  {
+    std::lock_guard<std::mutex> lock(frame_mutex);
+    
+    // 更新FPS计算
+    updateFPS();
+    
+    // 帧数据只读共享，只有需要显示时才复制一份用于绘制
+    const cv::Mat &frame_img = result_obj.cur_frame->img;
+    cv::Mat display_img;
+    if (show_image && !(result_obj.dets.empty() && isInPoint == 1)) {
+      display_img = frame_img.clone();
+    }
+    int width = frame_img.cols;
+    int height = frame_img.rows;
+    
+    // 检查物资识别模型是否有结果
+    if (!result_obj.dets.empty()) {
+      // 物资识别模型有结果，处理结果
+      hasObjectDetected = false;  // 先重置检测标志
+      
+      // 过滤置信度低于0.65的检测框
+      std::vector<DetectionBox> valid_material_dets;
+      for (auto &res : result_obj.dets) {
+        // 只保留置信度大于等于0.65的检测框
+        if (res.score >= 0.65) {
+          // 检查检测框是否有效
+          if (res.box.width <= 0 || res.box.height <= 0 || 
+              res.box.x < 0 || res.box.y < 0 || 
+              res.box.x + res.box.width > width || 
+              res.box.y + res.box.height > height) {
+            continue;
+          }
           
-          detectPoolNum->put(display_img, cur_frame_id);
           
-          // 获取数字识别结果
-          DetectResultsGroup result_num;
-          detectPoolNum->get(result_num);
           
-          // 处理数字识别结果
-          if (!result_num.dets.empty()) {
-            // 先过滤无效的检测框和置信度低的检测框
-            std::vector<DetectionBox> valid_dets;
-            for (auto &res : result_num.dets) {
-              // 只保留置信度大于等于0.65的检测框
-              if (res.score >= 0.65) {
-                
-                
-                // 为数字模型结果设置正确的类别名称
-                if (res.obj_id >= 0 && res.obj_id < OBJ_DIGIT_CLASS_NUM) {
-                  res.det_name = digit_labels[res.obj_id];
-                } else {
-                  ROS_WARN("Invalid digit ID: %d (max: %d)", res.obj_id, OBJ_DIGIT_CLASS_NUM - 1);
-                  res.det_name = "unknown_digit";
-                  continue; // 跳过无效数字
-                }
-                
-                if (res.box.width > 0 && res.box.height > 0 && 
-                    res.box.x >= 0 && res.box.y >= 0 && 
-                    res.box.x + res.box.width <= width && 
-                    res.box.y + res.box.height <= height) {
-                  valid_dets.push_back(res);
-                }
-              }
-            }
-            
-            // 首先检查是否可以组合多位数
-            if (valid_dets.size() >= 2) {
-              // 尝试组合多位数
-              rknn_pt::ObjectDetection multi_digit_msg = processMultiDigitNumber(valid_dets, width, height);
-              
-              // 如果成功组合，发布组合后的结果
-              if (!multi_digit_msg.object_type.empty()) {
-                multi_digit_msg.is_in_position = isInPoint;  // 添加位置信息
-                det_pub.publish(multi_digit_msg);
-                
-                // 检查是否所有检测都是数字
-                bool all_are_digits = true;
-                int combined_value = 0;
-                std::vector<DetectionBox> digit_dets;
-                
-                for (const auto &res : valid_dets) {
-                  // 查找数字对应的值
-                  const std::string &name = res.det_name;
-                  auto it = digit_map.find(name);
-                  if (it != digit_map.end()) {
-                    digit_dets.push_back(res);
-                  } else {
-                    all_are_digits = false;
-                    break;
-                  }
-                }
-                
-                if (all_are_digits && digit_dets.size() >= 2) {
-                  // 计算组合值
-                  std::vector<DetectionBox> sorted_detections = digit_dets;
-                  std::sort(sorted_detections.begin(), sorted_detections.end(), 
-                      [](const DetectionBox& a, const DetectionBox& b) {
-                          return a.box.x < b.box.x;
-                      });
-                  
-                  for (const auto& det : sorted_detections) {
-                    auto it = digit_map.find(det.det_name);
-                    if (it != digit_map.end()) {
-                        int digit_value = it->second;
-                        combined_value = combined_value * 10 + digit_value;
-                    }
-                  }
-                  
-                  // 绘制组合数字
-                  drawCombinedDigits(display_img, digit_dets, combined_value);
-                }
-              } else {
-                // 如果无法组合，按单个数字处理
-                enhancedDrawDetections(display_img, valid_dets);
-                
-                for (const auto &res : valid_dets) {
-                  // 计算中心坐标
-                  int center_x = res.box.x + res.box.width / 2;
-                  int center_y = res.box.y + res.box.height / 2;
-                  
-                  // 计算相对于图像中心的偏移
-                  int offset_center_x = center_x - width / 2;
-                  int offset_center_y = center_y - height / 2;
-                  
-                  // 创建检测消息
-                  rknn_pt::ObjectDetection det_msg;
-                  det_msg.object_type = res.det_name;
-                  det_msg.center_x = offset_center_x;
-                  det_msg.center_y = offset_center_y;
-                  det_msg.confidence = res.score;
-                  det_msg.is_in_position = isInPoint;  // 添加位置信息
-                  
-                  // 发布消息
-                  det_pub.publish(det_msg);
-                  
-                  ROS_INFO("Detected number: %s (id: %d) at [%d, %d] with confidence %.2f, isInPoint: %d", 
-                           res.det_name.c_str(), res.obj_id, offset_center_x, offset_center_y, res.score, isInPoint);
-                }
-              }
-            } else if (valid_dets.size() == 1) {
-              // 单个数字处理
-              enhancedDrawDetections(display_img, valid_dets);
-              
-              const auto &res = valid_dets[0];
-              // 计算中心坐标
-              int center_x = res.box.x + res.box.width / 2;
-              int center_y = res.box.y + res.box.height / 2;
-              
-              // 计算相对于图像中心的偏移
-              int offset_center_x = center_x - width / 2;
-              int offset_center_y = center_y - height / 2;
-              
-              // 创建检测消息
-              rknn_pt::ObjectDetection det_msg;
-              det_msg.object_type = res.det_name;
-              det_msg.center_x = offset_center_x;
-              det_msg.center_y = offset_center_y;
-              det_msg.confidence = res.score;
-              det_msg.is_in_position = isInPoint;  // 添加位置信息
-              
-              // 发布消息
-              det_pub.publish(det_msg);
-              
-              ROS_INFO("Detected number: %s (id: %d) at [%d, %d] with confidence %.2f, isInPoint: %d", 
-                       res.det_name.c_str(), res.obj_id, offset_center_x, offset_center_y, res.score, isInPoint);
-            } else {
-              ROS_INFO("No valid digit detections");
-            }
+          // 为物资模型结果设置正确的类别名称
+          if (res.obj_id >= 0 && res.obj_id < OBJ_MATERIAL_CLASS_NUM) {
+            res.det_name = material_labels[res.obj_id];
           } else {
-            ROS_INFO("No numbers detected");
+            ROS_WARN("Invalid material ID: %d (max: %d)", res.obj_id, OBJ_MATERIAL_CLASS_NUM - 1);
+            res.det_name = "unknown_material";
           }
-        } else {
-          ROS_INFO("未到达指定位置，继续使用物资识别模型");
+          
+          valid_material_dets.push_back(res);
+          hasObjectDetected = true;  // 有有效的物体检测
         }
       }
       
-      // 在右上角显示FPS
-      displayFPS(display_img);
-    } // 锁在这里释放
-    
-    // 显示处理后的图像 - 在锁之外，减少锁持有时间
-    if (!display_img.empty()) {
-      cv::imshow("Detection Results", display_img);
+      // 处理有效的物资检测结果
+      for (auto &res : valid_material_dets) {
+        // 计算中心坐标
+        int center_x = res.box.x + res.box.width / 2;
+        int center_y = res.box.y + res.box.height / 2;
+        
+        // 计算相对于图像中心的偏移
+        int offset_center_x = center_x - width / 2;
+        int offset_center_y = center_y - height / 2;
+        
+        // 创建检测消息
+        rknn_pt::ObjectDetection det_msg;
+        det_msg.object_type = res.det_name;
+        det_msg.center_x = offset_center_x;
+        det_msg.center_y = offset_center_y;
+        det_msg.confidence = res.score;
+        det_msg.is_in_position = isInPoint;  // 添加位置信息
+        
+        // 发布消息
+        det_pub.publish(det_msg);
+        
+        ROS_INFO("Detected object: %s (id: %d) at [%d, %d] with confidence %.2f, isInPoint: %d", 
+                 res.det_name.c_str(), res.obj_id, offset_center_x, offset_center_y, res.score, isInPoint);
+      }
+      
+      // 绘制物资检测结果
+      enhancedDrawDetections(display_img, valid_material_dets);
+    } else {
+      // 物资识别模型无结果
+      hasObjectDetected = false;  // 标记未检测到物体
       
-      // 按q键退出
-      int key = cv::waitKey(1);
-      if (key == 'q') {
-        ros::shutdown();
+      // 仅当到达指定位置并且未检测到物体时才切换到数字识别模型
+      if (isInPoint == 1) {
+        ROS_INFO("已到达指定位置，且未检测到物体，切换到数字识别模型");
+        need_number = true;
+      } else {
+        ROS_INFO("未到达指定位置，继续使用物资识别模型");
       }
     }
+    
+    if (!need_number) {
+      submitDisplay(display_img);
+    }
+  } // 锁在这里释放，数字模型池put可能阻塞，不能持锁调用
+  
+  // 同一帧交给数字识别模型，结果由onNumberResult处理和显示
+  if (need_number && detectPoolNum) {
+    detectPoolNum->put(result_obj.cur_frame, result_obj.cur_frame_id);
+  }
+}
+
+// 图像回调函数，接收ROS图像并送入物资识别流水线，结果由onObjectResult异步处理
+void imageCallback(const sensor_msgs::ImageConstPtr &msg)
+{
+  try
+  {
+    // 首先尝试转换ROS图像为OpenCV格式，bgr8时直接共享消息内存
+    cv_bridge::CvImageConstPtr cv_ptr = cv_bridge::toCvShare(msg, "bgr8");
+    if (cv_ptr->image.empty()) {
+      ROS_ERROR("Received empty image from camera");
+      return;
+    }
+    
+    // 检查模型指针
+    if (!detectPoolObj || !detectPoolNum) {
+      ROS_ERROR("Detection models not initialized properly");
+      return;
+    }
+    
+    // 帧句柄持有cv_ptr（进而持有ROS消息），整条流水线共享同一份图像数据
+    FramePtr frame = make_frame(cv_ptr->image, std::shared_ptr<const void>(cv_ptr.get(), [cv_ptr](const void *) {}));
+    
+    {
+      std::lock_guard<std::mutex> lock(frame_mutex);
+      
+      // 更新全局帧以供其他地方使用（如果需要）
+      ros_frame = frame;
+    }
+    
+    // 提交到物资识别模型池，在途帧数达到上限时在这里等待；帧号在池内必须唯一，不能用主循环计数
+    int frame_id = image_frame_id++;
+    if (detectPoolObj->put(frame, frame_id) < 0) {
+      ROS_WARN("Frame %d rejected by object pool", frame_id);
+    }
   }
   catch (cv_bridge::Exception &e)
   {
@@ -663,6 +943,7 @@ int main(int argc, char **argv)
   // 初始化ROS节点,创建ROS节点句柄，用于与ROS系统进行交互
   ros::init(argc, argv, "det_node");
   ros::NodeHandle nh;
+  auto startup_begin = std::chrono::steady_clock::now();  // 启动耗时统计的起点
   
   try {
     // 创建发布器，使用自定义消息类型，话题名称为"Detect_result"
@@ -686,6 +967,47 @@ int main(int argc, char **argv)
     // 从参数服务器获取置信度和NMS阈值 (默认设置为0.65)
     nh.param<float>("box_conf_threshold", box_conf_threshold, 0.65);
     nh.param<float>("nms_threshold", nms_threshold, NMS_THRESH);
+    // NMS前只保留得分最高的候选数，0为不限制（杂乱场景下限制后处理耗时）
+    int max_candidates = 0;
+    nh.param<int>("max_candidates", max_candidates, 0);
+    // 各模型的NMS方式："pairwise"逐对比较，"grid"网格哈希（调低置信度阈值、候选上千时更快，结果相同）
+    std::string obj_nms_mode, num_nms_mode;
+    nh.param<std::string>("obj_nms_mode", obj_nms_mode, "pairwise");
+    nh.param<std::string>("num_nms_mode", num_nms_mode, "pairwise");
+    // 由粗到细解码：粗尺度（stride 16/32）box置信度均低于 置信度阈值 - coarse_margin 时跳过stride 8，否则只解码活跃区域附近
+    bool coarse_to_fine = false;
+    // 余量越大粗尺度越容易判为活跃，漏检越少、节省越少；默认值未在录制的输出上标定召回，偏保守
+    float coarse_margin = COARSE_MARGIN;
+    nh.param<bool>("coarse_to_fine", coarse_to_fine, false);
+    nh.param<float>("coarse_margin", coarse_margin, COARSE_MARGIN);
+    // 静态忽略区域：落在其中的网格单元在解码时直接跳过（车体、画面下方等不会出现目标的区域）
+    IgnoreRegions ignore_obj, ignore_num;
+    loadIgnoreRegions(nh, "obj_", ignore_obj);
+    loadIgnoreRegions(nh, "num_", ignore_num);
+    // 任务阶段类别子集：只解码列出的类别（下标或名称），不设置时解码全部类别；运行中可通过set_active_classes服务切换
+    std::vector<int> obj_active_classes, num_active_classes;
+    loadActiveClasses(nh, "obj", obj_active_classes);
+    loadActiveClasses(nh, "num", num_active_classes);
+    // 帧内并行解码：decode_threads > 0 时各输出头和stride 8的行带在共享线程池上并行解码，0为在推理线程上串行解码
+    int decode_threads = 0;
+    int decode_bands = 4;
+    nh.param<int>("decode_threads", decode_threads, 0);
+    nh.param<int>("decode_bands", decode_bands, 4);
+    // 原生布局输出：NPU输出直接以NHWC/NC1HWC2写入绑定的内存并在原生布局上解码，省去rknn_outputs_get的布局转换
+    bool native_output = false;
+    nh.param<bool>("native_output", native_output, false);
+    // 零拷贝输入：模型输入用rknn_create_mem分配并绑定，RGA按fd导入后直接写入，省去rknn_inputs_set的拷贝
+    bool zero_copy_input = false;
+    nh.param<bool>("zero_copy_input", zero_copy_input, false);
+    // 预处理方式：true时一次RGA任务完成BGR→RGB和缩放，false时由CPU完成
+    bool rga_preprocess = true;
+    nh.param<bool>("rga_preprocess", rga_preprocess, true);
+    // 是否保持宽高比缩放（letterbox），默认拉伸到模型输入尺寸
+    bool letterbox = false;
+    nh.param<bool>("letterbox", letterbox, false);
+    
+    // 是否显示检测结果图像
+    nh.param<bool>("show_image", show_image, true);
     
     ROS_INFO("Loading object model from: %s", object_model_path.c_str());
     ROS_INFO("Loading number model from: %s", number_model_path.c_str());
@@ -714,54 +1036,189 @@ int main(int argc, char **argv)
     nh.param<int>("threadNum_obj", threadNum_obj, 2);
     nh.param<int>("threadNum_num", threadNum_num, 2);
     
-    ROS_INFO("Initializing object detection model with %d threads", threadNum_obj);
+    // 预热配置：每个上下文在合成帧上推理的次数（0为不预热），合成帧尺寸应与相机分辨率一致
+    int warmup_frames = 2;
+    int warmup_width = 640;
+    int warmup_height = 480;
+    nh.param<int>("warmup_frames", warmup_frames, 2);
+    nh.param<int>("warmup_width", warmup_width, 640);
+    nh.param<int>("warmup_height", warmup_height, 480);
+    
+    ROS_INFO("Initializing object detection model with %d threads, number detection model with %d threads",
+             threadNum_obj, threadNum_num);
     
-    // 创建并初始化模型池 - 首先只初始化物体检测模型
-    detectPoolObj = new rknnPool<RkPt, cv::Mat, DetectResultsGroup>(object_model_path, threadNum_obj);
+    // 创建两个模型池并同时初始化：两个模型的加载互不依赖；各自池内的复制上下文串行创建
+    detectPoolObj = new rknnPool<RkPt, FramePtr, DetectResultsGroup>(object_model_path, threadNum_obj);
+    detectPoolNum = new rknnPool<RkPt, FramePtr, DetectResultsGroup>(number_model_path, threadNum_num);
+    auto init_begin = std::chrono::steady_clock::now();
+    auto init_pool = [init_begin](rknnPool<RkPt, FramePtr, DetectResultsGroup> *pool, double *ms) {
+      int ret = pool->init();
+      *ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - init_begin).count();
+      return ret;
+    };
+    double init_obj_ms = 0, init_num_ms = 0;
+    std::future<int> init_obj = std::async(std::launch::async, init_pool, detectPoolObj, &init_obj_ms);
+    std::future<int> init_num = std::async(std::launch::async, init_pool, detectPoolNum, &init_num_ms);
+    int ret_obj = init_obj.get();
+    int ret_num = init_num.get();
+    auto init_end = std::chrono::steady_clock::now();
     
-    if (detectPoolObj->init() != 0) {
-      ROS_ERROR("Object detection model initialization failed!");
-      delete detectPoolObj;//释放资源
+    if (ret_obj != 0 || ret_num != 0) {
+      if (ret_obj != 0) {
+        ROS_ERROR("Object detection model initialization failed!");
+      }
+      if (ret_num != 0) {
+        ROS_ERROR("Number detection model initialization failed!");
+      }
+      delete detectPoolNum;//释放资源
+      delete detectPoolObj;
+      detectPoolNum = nullptr;
       detectPoolObj = nullptr;
       return -1;
     }
     
-    // 设置物体检测模型的置信度和NMS阈值
-    RkPt* model_obj = detectPoolObj->get_model_ptr();
-    if (model_obj) {
-      model_obj->set_thresholds(box_conf_threshold, nms_threshold);
-      model_obj->set_model_type(MODEL_MATERIAL); // 设置为物资识别模型
-      ROS_INFO("Set object model thresholds: conf=%.2f, nms=%.2f", box_conf_threshold, nms_threshold);
-    }
+    // 设置物体检测模型的置信度和NMS阈值，所有上下文保持一致
+    detectPoolObj->for_each_model([&](RkPt *model) {
+      model->set_thresholds(box_conf_threshold, nms_threshold);
+      model->set_max_candidates(max_candidates);
+      model->set_nms_mode(obj_nms_mode == "grid" ? NMS_GRID : NMS_PAIRWISE);
+      model->set_coarse_to_fine(coarse_to_fine, coarse_margin);
+      model->set_ignore_regions(ignore_obj);
+      model->set_rga_preprocess(rga_preprocess);
+      model->set_letterbox(letterbox);
+      model->set_model_type(MODEL_MATERIAL); // 设置为物资识别模型
+    });
+    ROS_INFO("Set object model thresholds: conf=%.2f, nms=%.2f, max_candidates=%d, nms_mode=%s", box_conf_threshold,
+             nms_threshold, max_candidates, obj_nms_mode.c_str());
     
     ROS_INFO("Object detection model initialized successfully");
-    ROS_INFO("Initializing number detection model with %d threads", threadNum_num);
     
-    // 初始化数字检测模型
-    detectPoolNum = new rknnPool<RkPt, cv::Mat, DetectResultsGroup>(number_model_path, threadNum_num);
+    // 设置数字检测模型的属性，所有上下文保持一致
+    detectPoolNum->for_each_model([&](RkPt *model) {
+      model->set_thresholds(box_conf_threshold, nms_threshold);
+      model->set_max_candidates(max_candidates);
+      model->set_nms_mode(num_nms_mode == "grid" ? NMS_GRID : NMS_PAIRWISE);
+      model->set_coarse_to_fine(coarse_to_fine, coarse_margin);
+      model->set_ignore_regions(ignore_num);
+      model->set_rga_preprocess(rga_preprocess);
+      model->set_letterbox(letterbox);
+      model->set_model_type(MODEL_DIGIT); // 设置为数字识别模型
+    });
+    ROS_INFO("Set number model thresholds: conf=%.2f, nms=%.2f, max_candidates=%d, nms_mode=%s", box_conf_threshold,
+             nms_threshold, max_candidates, num_nms_mode.c_str());
     
-    if (detectPoolNum->init() != 0) {
-      ROS_ERROR("Number detection model initialization failed!");
-      delete detectPoolNum;//释放资源
-      delete detectPoolObj;//释放第一个模型资源
-      detectPoolNum = nullptr;
-      detectPoolObj = nullptr;
-      return -1;
+    ROS_INFO("Number detection model initialized successfully");
+    
+    // 设置启动时参与解码的类别
+    std::string active_message;
+    if (!applyActiveClasses("obj", obj_active_classes, active_message) ||
+        !applyActiveClasses("num", num_active_classes, active_message)) {
+      ROS_WARN("Active classes not applied: %s, decoding all classes", active_message.c_str());
     }
     
-    // 获取数字检测模型指针并设置属性
-    RkPt* model_num = detectPoolNum->get_model_ptr();
-    if (model_num) {
-      model_num->set_thresholds(box_conf_threshold, nms_threshold);
-      model_num->set_model_type(MODEL_DIGIT); // 设置为数字识别模型
-      ROS_INFO("Set number model thresholds: conf=%.2f, nms=%.2f", box_conf_threshold, nms_threshold);
+    // 开启原生布局输出，失败的上下文继续使用NCHW输出；部分绑定后失败的上下文不可用，初始化失败
+    if (native_output) {
+      int native_failed = 0, native_broken = 0;
+      auto enable_native = [&](RkPt *model) {
+        int ret = model->enable_native_output();
+        if (ret == -2) {
+          native_broken++;
+        } else if (ret != 0) {
+          native_failed++;
+        }
+      };
+      detectPoolObj->for_each_model(enable_native);
+      detectPoolNum->for_each_model(enable_native);
+      if (native_broken > 0) {
+        ROS_ERROR("Native output left %d contexts partially bound, cannot continue", native_broken);
+        delete detectPoolNum;
+        delete detectPoolObj;
+        detectPoolNum = nullptr;
+        detectPoolObj = nullptr;
+        return -1;
+      }
+      if (native_failed > 0) {
+        ROS_WARN("Native output not available on %d contexts, using NCHW output there", native_failed);
+      }
     }
     
-    ROS_INFO("Number detection model initialized successfully");
+    // 开启零拷贝输入，失败的上下文继续使用主机内存输入
+    if (zero_copy_input) {
+      int zero_copy_failed = 0;
+      auto enable_zero_copy = [&](RkPt *model) {
+        if (model->enable_zero_copy_input() != 0) {
+          zero_copy_failed++;
+        }
+      };
+      detectPoolObj->for_each_model(enable_zero_copy);
+      detectPoolNum->for_each_model(enable_zero_copy);
+      if (zero_copy_failed > 0) {
+        ROS_WARN("Zero copy input not available on %d contexts, using host memory input there", zero_copy_failed);
+      }
+    }
+    
+    // 创建两个模型共享的解码线程池
+    if (decode_threads > 0) {
+      decodePool = new dpool::ThreadPool(decode_threads);
+      auto apply_decode_pool = [&](RkPt *model) { model->set_decode_pool(decodePool, decode_bands); };
+      detectPoolObj->for_each_model(apply_decode_pool);
+      detectPoolNum->for_each_model(apply_decode_pool);
+    }
+    ROS_INFO("Intra-frame parallel decode: threads=%d, bands=%d", decode_threads, decode_bands);
+    ros::ServiceServer active_classes_srv = nh.advertiseService("set_active_classes", setActiveClassesCallback);
+    
+    // 流水线配置：每个模型池的最大在途帧数，默认每个上下文一帧推理、一帧排队（线程数 × CONTEXT_JOBS）
+    int pipeline_depth_obj = threadNum_obj * CONTEXT_JOBS;
+    int pipeline_depth_num = threadNum_num * CONTEXT_JOBS;
+    nh.param<int>("pipeline_depth_obj", pipeline_depth_obj, threadNum_obj * CONTEXT_JOBS);
+    nh.param<int>("pipeline_depth_num", pipeline_depth_num, threadNum_num * CONTEXT_JOBS);
+    
+    // 结果交付方式："latest"只交付最新完成的帧（控制回路更关心时效），"in_order"严格按帧序交付
+    std::string delivery_mode;
+    nh.param<std::string>("delivery_mode", delivery_mode, "latest");
+    DeliveryMode mode = (delivery_mode == "in_order") ? DELIVER_IN_ORDER : DELIVER_LATEST;
+    
+    // 开启流水线模式，结果通过回调交付
+    detectPoolObj->set_pipeline(pipeline_depth_obj, onObjectResult, mode);
+    detectPoolNum->set_pipeline(pipeline_depth_num, onNumberResult, mode);
+    ROS_INFO("Pipeline depth: object=%d, number=%d, delivery mode: %s", pipeline_depth_obj, pipeline_depth_num,
+             mode == DELIVER_IN_ORDER ? "in_order" : "latest");
+    
+    // 准入队列配置：推理跟不上相机时，超出在途上限的帧最多排队admission_queue_size帧，
+    // 队列满时按admission_policy处理："block"阻塞回调，"drop_newest"丢弃新帧，"drop_oldest"用新帧替换最旧的帧
+    int admission_queue_size = 1;
+    std::string admission_policy;
+    nh.param<int>("admission_queue_size", admission_queue_size, 1);
+    nh.param<std::string>("admission_policy", admission_policy, "drop_oldest");
+    AdmissionPolicy policy = ADMIT_DROP_OLDEST;
+    if (admission_policy == "block") {
+      policy = ADMIT_BLOCK;
+    } else if (admission_policy == "drop_newest") {
+      policy = ADMIT_DROP_NEWEST;
+    }
+    detectPoolObj->set_admission(admission_queue_size, policy);
+    detectPoolNum->set_admission(admission_queue_size, policy);
+    ROS_INFO("Admission queue size: %d, policy: %s", admission_queue_size, admission_policy.c_str());
+    
+    ROS_INFO("Coarse-to-fine decode: %s, margin=%.2f", coarse_to_fine ? "on" : "off", coarse_margin);
+    
+    // 预热完成即订阅相机，不再固定等待
+    auto warmup_begin = std::chrono::steady_clock::now();
+    if (warmup_frames > 0) {
+      warmUpModels(warmup_frames, warmup_width, warmup_height);
+    }
+    auto warmup_end = std::chrono::steady_clock::now();
     ROS_INFO("Both detection models are ready");
     
-    // 安全延迟 - 等待系统稳定
-    ros::Duration(1.0).sleep();
+    // 启动耗时：参数读取、模型池初始化（并行，括号内为各自完成时间）、配置、预热
+    auto ms_between = [](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+      return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    ROS_INFO("Startup time: params=%.1fms, init=%.1fms (object=%.1fms, number=%.1fms), setup=%.1fms, "
+             "warm-up=%.1fms (%d frames x %d contexts), total=%.1fms",
+             ms_between(startup_begin, init_begin), ms_between(init_begin, init_end), init_obj_ms, init_num_ms,
+             ms_between(init_end, warmup_begin), ms_between(warmup_begin, warmup_end), warmup_frames,
+             threadNum_obj + threadNum_num, ms_between(startup_begin, warmup_end));
     
     // 创建图像订阅器 - 最后创建，以确保所有初始化完成
     ROS_INFO("Subscribing to camera topic: /usb_cam/image_raw");
@@ -779,6 +1236,20 @@ int main(int argc, char **argv)
       // 处理回调
       ros::spinOnce();
       
+      // 显示最新的检测结果
+      showLatestDisplay();
+      
+      // 定期输出丢帧统计
+      PoolStats stats_obj = detectPoolObj->get_stats();
+      ROS_INFO_THROTTLE(10, "Object pool: submitted=%lld delivered=%lld dropped(newest=%lld, oldest=%lld, stale=%lld) queued=%d in_flight=%d",
+                        stats_obj.submitted, stats_obj.delivered, stats_obj.droppedNewest, stats_obj.droppedOldest,
+                        stats_obj.staleDropped, stats_obj.queued, stats_obj.inFlight);
+      
+      // 约每10秒输出一次各上下文的排队时间（60Hz循环）
+      if (cur_frame_id % 600 == 0) {
+        logContextStats("Object pool", detectPoolObj);
+      }
+      
       // 控制处理频率
       loop_rate.sleep();
     }
@@ -793,6 +1264,17 @@ int main(int argc, char **argv)
   // 安全释放资源
   ROS_INFO("Shutting down and cleaning up resources...");
   
+  if (detectPoolObj && detectPoolNum) {
+    PoolStats stats_obj = detectPoolObj->get_stats();
+    PoolStats stats_num = detectPoolNum->get_stats();
+    ROS_INFO("Object pool dropped: newest=%lld, oldest=%lld, stale=%lld",
+             stats_obj.droppedNewest, stats_obj.droppedOldest, stats_obj.staleDropped);
+    ROS_INFO("Number pool dropped: newest=%lld, oldest=%lld, stale=%lld",
+             stats_num.droppedNewest, stats_num.droppedOldest, stats_num.staleDropped);
+    logContextStats("Object pool", detectPoolObj);
+    logContextStats("Number pool", detectPoolNum);
+  }
+  
   if (detectPoolObj) {
     delete detectPoolObj;
     detectPoolObj = nullptr;
@@ -803,6 +1285,12 @@ int main(int argc, char **argv)
     detectPoolNum = nullptr;
   }
   
+  // 模型池析构时已等待所有在途帧完成，此后不再有解码任务
+  if (decodePool) {
+    delete decodePool;
+    decodePool = nullptr;
+  }
+  
   // 关闭所有OpenCV窗口
   cv::destroyAllWindows();
   
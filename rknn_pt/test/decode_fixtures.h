@@ -0,0 +1,157 @@
+#ifndef DECODE_FIXTURES_H_
+#define DECODE_FIXTURES_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <random>
+#include <vector>
+
+#include "det/postprocess.h"
+
+// 解码测试用的输出张量：三个输出头按YOLOv5的NCHW int8布局存放，与rknn_outputs_get取回的默认布局相同
+typedef struct _TestHeads
+{
+    int in_h, in_w;                         // 模型输入尺寸
+    DecodeLayout layout;                    // 解码布局
+    HeadQuantTable tables[OBJ_HEAD_NUM];    // 各输出头的量化查找表
+    std::vector<int8_t> data[OBJ_HEAD_NUM]; // 各输出头的数据
+} TestHeads;
+
+// 按模型输入尺寸和类别数构建布局和查找表（步长8/16/32），数据清零为最小量化值
+inline int init_test_heads(TestHeads *t, int in_h, int in_w, int num_classes, float conf_threshold,
+                           int32_t zp = -128, float scale = 1.0f / 255)
+{
+    t->in_h = in_h;
+    t->in_w = in_w;
+    int channels[OBJ_HEAD_NUM], grid_h[OBJ_HEAD_NUM], grid_w[OBJ_HEAD_NUM];
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    {
+        channels[h] = (5 + num_classes) * OBJ_ANCHOR_NUM;
+        grid_h[h] = in_h / (8 << h);
+        grid_w[h] = in_w / (8 << h);
+    }
+    if (build_decode_layout(&t->layout, in_h, in_w, channels, grid_h, grid_w) < 0)
+        return -1;
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    {
+        build_quant_table(&t->tables[h], zp, scale, conf_threshold);
+        t->data[h].assign((size_t)channels[h] * grid_h[h] * grid_w[h], -128);
+    }
+    return 0;
+}
+
+// 通道c、网格单元cell的值
+inline int8_t &head_at(TestHeads *t, int h, int c, int cell)
+{
+    return t->data[h][(size_t)c * t->layout.grid_h[h] * t->layout.grid_w[h] + cell];
+}
+
+// 随机填充：每个网格单元的box置信度以obj_rate的概率通过阈值，类别概率和box参数均匀随机，
+// box宽高的量化值限制在[wh_lo, wh_hi]内以控制框的大小
+inline void fill_random_heads(TestHeads *t, unsigned seed, float obj_rate, int wh_lo = -128, int wh_hi = 127)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> any(-128, 127), wh(wh_lo, wh_hi);
+    std::uniform_real_distribution<float> coin(0.f, 1.f);
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    {
+        int thres = t->tables[h].thres_i8;
+        std::uniform_int_distribution<int> above(thres, 127), below(-128, thres > -128 ? thres - 1 : -128);
+        int grid_len = t->layout.grid_h[h] * t->layout.grid_w[h];
+        for (int a = 0; a < OBJ_ANCHOR_NUM; a++)
+        {
+            int c0 = t->layout.prop_size * a;
+            for (int cell = 0; cell < grid_len; cell++)
+            {
+                head_at(t, h, c0 + 0, cell) = (int8_t)any(rng);
+                head_at(t, h, c0 + 1, cell) = (int8_t)any(rng);
+                head_at(t, h, c0 + 2, cell) = (int8_t)wh(rng);
+                head_at(t, h, c0 + 3, cell) = (int8_t)wh(rng);
+                head_at(t, h, c0 + 4, cell) = (int8_t)(coin(rng) < obj_rate ? above(rng) : below(rng));
+                for (int k = 0; k < t->layout.num_classes; k++)
+                    head_at(t, h, c0 + 5 + k, cell) = (int8_t)any(rng);
+            }
+        }
+    }
+}
+
+// 在[row0, row0 + rows) x [col0, col0 + cols)网格区域内让所有anchor的box置信度都通过阈值，
+// 用于构造同一位置大量重叠候选（网格NMS单个网格链表很长）的情况
+inline void fill_dense_cluster(TestHeads *t, int h, int row0, int col0, int rows, int cols)
+{
+    int grid_w = t->layout.grid_w[h];
+    for (int a = 0; a < OBJ_ANCHOR_NUM; a++)
+    {
+        for (int i = row0; i < row0 + rows && i < t->layout.grid_h[h]; i++)
+        {
+            for (int j = col0; j < col0 + cols && j < grid_w; j++)
+                head_at(t, h, t->layout.prop_size * a + 4, i * grid_w + j) = 127;
+        }
+    }
+}
+
+// 默认后处理配置：逐对NMS、不限制候选数、串行解码、全部类别
+inline PostProcessConfig test_config(float nms_threshold)
+{
+    PostProcessConfig config;
+    memset(&config, 0, sizeof(config));
+    config.nms_threshold = nms_threshold;
+    config.nms_mode = NMS_PAIRWISE;
+    config.decode_bands = 4;
+    return config;
+}
+
+// 在测试数据上运行后处理，不做letterbox填充，缩放比例为1（结果为模型输入坐标）
+inline int run_post_process(TestHeads *t, const PostProcessConfig &config, PostProcessWorkspace *ws,
+                            DetectResultsGroup *group, int8_t *const *heads = NULL)
+{
+    BOX_RECT pads;
+    memset(&pads, 0, sizeof(pads));
+    int8_t *in[OBJ_HEAD_NUM];
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+        in[h] = heads ? heads[h] : t->data[h].data();
+    return post_process(in[0], in[1], in[2], t->in_h, t->in_w, &config, pads, 1.0f, 1.0f, &t->layout, t->tables,
+                        ws, group);
+}
+
+// 计时期间把标准输出重定向到/dev/null：post_process对每个结果打印一行，避免打印耗时混入测量
+class QuietStdout
+{
+private:
+    int saved;
+
+public:
+    QuietStdout()
+    {
+        fflush(stdout);
+        saved = dup(1);
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, 1);
+        close(null_fd);
+    }
+    ~QuietStdout()
+    {
+        fflush(stdout);
+        dup2(saved, 1);
+        close(saved);
+    }
+};
+
+// 两组检测结果是否完全相同（顺序、框、得分、类别）
+inline bool same_detections(const DetectResultsGroup &a, const DetectResultsGroup &b)
+{
+    if (a.dets.size() != b.dets.size())
+        return false;
+    for (size_t i = 0; i < a.dets.size(); i++)
+    {
+        const DetectionBox &x = a.dets[i], &y = b.dets[i];
+        if (!(x.box == y.box) || x.score != y.score || x.obj_id != y.obj_id)
+            return false;
+    }
+    return true;
+}
+
+#endif // DECODE_FIXTURES_H_
@@ -0,0 +1,417 @@
+#include "fake_rknn_runtime.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "rknn_api.h"
+#include "im2d.h"
+
+namespace fake_rknn
+{
+
+typedef std::chrono::steady_clock Clock;
+
+// 单个上下文的状态
+struct Context
+{
+    bool running;                       // 是否有推理在进行
+    int run_index;                      // 正在进行的推理是第几次rknn_run
+    uint8_t run_input;                  // 启动时输入的第一个字节
+    Clock::time_point finish;           // 完成时间
+    std::vector<uint8_t> host_input;    // rknn_inputs_set拷贝的输入
+    rknn_tensor_mem *input_mem;         // 绑定的模型输入内存，NULL表示使用拷贝的输入
+    rknn_tensor_mem *output_mems[3];    // 绑定的原生输出内存
+};
+
+static std::mutex mtx;
+static FakeConfig config = default_config();
+static FakeLog records;
+static std::map<rknn_context, Context> contexts;
+static rknn_context next_context = 1;
+static int run_count = 0;
+
+FakeConfig default_config()
+{
+    FakeConfig c;
+    c.in_h = 64;
+    c.in_w = 64;
+    c.num_classes = 15;
+    c.run_ms = 5;
+    c.native_nhwc = true;
+    c.fail_run_at = -1;
+    c.fail_wait_at = -1;
+    c.fail_output_bind_at = -1;
+    c.detect_class = -1;
+    return c;
+}
+
+void reset(const FakeConfig &c)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    config = c;
+    records = FakeLog();
+    contexts.clear();
+    run_count = 0;
+}
+
+void clear_log()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    int live = records.live_mems;
+    records = FakeLog();
+    records.live_mems = live;
+}
+
+FakeLog log()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return records;
+}
+
+static void violation(const std::string &what)
+{
+    records.violations.push_back(what);
+}
+
+static int channels()
+{
+    return 3 * (5 + config.num_classes);
+}
+
+static void fill_input_attr(rknn_tensor_attr *attr)
+{
+    attr->n_dims = 4;
+    attr->dims[0] = 1;
+    attr->dims[1] = config.in_h;
+    attr->dims[2] = config.in_w;
+    attr->dims[3] = 3;
+    attr->fmt = RKNN_TENSOR_NHWC;
+    attr->type = RKNN_TENSOR_UINT8;
+    attr->qnt_type = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+    attr->size = config.in_h * config.in_w * 3;
+    attr->size_with_stride = attr->size;
+    attr->w_stride = config.in_w;
+}
+
+static void fill_output_attr(rknn_tensor_attr *attr, int native)
+{
+    int i = attr->index, stride = 8 << i;
+    int grid_h = config.in_h / stride, grid_w = config.in_w / stride, c = channels();
+    attr->type = RKNN_TENSOR_INT8;
+    attr->qnt_type = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+    attr->zp = -128;
+    attr->scale = 1.0f / 255;
+    attr->size = grid_h * grid_w * c;
+    attr->size_with_stride = attr->size;
+    if (native == 0)
+    {
+        attr->n_dims = 4;
+        attr->dims[0] = 1;
+        attr->dims[1] = c;
+        attr->dims[2] = grid_h;
+        attr->dims[3] = grid_w;
+        attr->fmt = RKNN_TENSOR_NCHW;
+    }
+    else if (native == 1)
+    {
+        // 通道按16对齐
+        attr->n_dims = 4;
+        attr->dims[0] = 1;
+        attr->dims[1] = grid_h;
+        attr->dims[2] = grid_w;
+        attr->dims[3] = c;
+        attr->fmt = RKNN_TENSOR_NHWC;
+        attr->size_with_stride = grid_h * grid_w * ((c + 15) & ~15);
+    }
+    else
+    {
+        attr->n_dims = 5;
+        attr->dims[0] = 1;
+        attr->dims[1] = (c + 15) / 16;
+        attr->dims[2] = grid_h;
+        attr->dims[3] = grid_w;
+        attr->dims[4] = 16;
+        attr->fmt = RKNN_TENSOR_NC1HWC2;
+        attr->size_with_stride = attr->dims[1] * grid_h * grid_w * 16;
+    }
+}
+
+// 模型输入的第一个字节：绑定了输入内存时直接读取，否则取rknn_inputs_set拷贝的数据
+static uint8_t first_input_byte(const Context &ctx)
+{
+    if (ctx.input_mem)
+        return ((const uint8_t *)ctx.input_mem->virt_addr)[0];
+    return ctx.host_input.empty() ? 0 : ctx.host_input[0];
+}
+
+} // namespace fake_rknn
+
+using namespace fake_rknn;
+
+int rknn_init(rknn_context *context, void *model, uint32_t size, uint32_t, rknn_init_extend *)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (model == NULL || size == 0)
+        return -1;
+    *context = next_context++;
+    contexts[*context] = Context();
+    return 0;
+}
+
+int rknn_dup_context(rknn_context *context_in, rknn_context *context_out)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!contexts.count(*context_in))
+        return -1;
+    *context_out = next_context++;
+    contexts[*context_out] = Context();
+    return 0;
+}
+
+int rknn_destroy(rknn_context context)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (contexts.count(context) && contexts[context].running)
+        violation("rknn_destroy while running");
+    contexts.erase(context);
+    return 0;
+}
+
+int rknn_set_core_mask(rknn_context, rknn_core_mask)
+{
+    return 0;
+}
+
+int rknn_query(rknn_context context, rknn_query_cmd cmd, void *info, uint32_t)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!contexts.count(context))
+        return -1;
+    switch (cmd)
+    {
+    case RKNN_QUERY_SDK_VERSION:
+    {
+        rknn_sdk_version *version = (rknn_sdk_version *)info;
+        strcpy(version->api_version, "fake");
+        strcpy(version->drv_version, "fake");
+        return 0;
+    }
+    case RKNN_QUERY_IN_OUT_NUM:
+    {
+        rknn_input_output_num *num = (rknn_input_output_num *)info;
+        num->n_input = 1;
+        num->n_output = 3;
+        return 0;
+    }
+    case RKNN_QUERY_INPUT_ATTR:
+        fill_input_attr((rknn_tensor_attr *)info);
+        return 0;
+    case RKNN_QUERY_OUTPUT_ATTR:
+        fill_output_attr((rknn_tensor_attr *)info, 0);
+        return 0;
+    case RKNN_QUERY_NATIVE_NHWC_OUTPUT_ATTR:
+        if (!config.native_nhwc)
+            return -1;
+        fill_output_attr((rknn_tensor_attr *)info, 1);
+        return 0;
+    case RKNN_QUERY_NATIVE_OUTPUT_ATTR:
+        fill_output_attr((rknn_tensor_attr *)info, 2);
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+int rknn_inputs_set(rknn_context context, uint32_t n_inputs, rknn_input inputs[])
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Context &ctx = contexts[context];
+    if (ctx.running)
+        violation("rknn_inputs_set while running");
+    if (n_inputs != 1 || inputs[0].size != (uint32_t)(config.in_h * config.in_w * 3))
+        return -1;
+    ctx.host_input.assign((const uint8_t *)inputs[0].buf, (const uint8_t *)inputs[0].buf + inputs[0].size);
+    ctx.input_mem = NULL;
+    return 0;
+}
+
+int rknn_run(rknn_context context, rknn_run_extend *extend)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Context &ctx = contexts[context];
+    if (ctx.running)
+        violation("rknn_run while running");
+    if (extend == NULL || !extend->non_block)
+        violation("rknn_run is blocking");
+    int index = run_count++;
+    if (index == config.fail_run_at)
+        return -1;
+    ctx.running = true;
+    ctx.run_index = index;
+    ctx.run_input = first_input_byte(ctx);
+    ctx.finish = Clock::now() + std::chrono::milliseconds(config.run_ms);
+    records.run_inputs.push_back(ctx.run_input);
+    return 0;
+}
+
+int rknn_wait(rknn_context context, rknn_run_extend *extend)
+{
+    Clock::time_point finish;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        Context &ctx = contexts[context];
+        if (!ctx.running)
+        {
+            violation("rknn_wait without a run");
+            return -1;
+        }
+        finish = ctx.finish;
+        records.waits++;
+    }
+    if (extend && extend->timeout_ms > 0 && Clock::now() + std::chrono::milliseconds(extend->timeout_ms) < finish)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(extend->timeout_ms));
+        std::lock_guard<std::mutex> lock(mtx);
+        records.wait_timeouts++;
+        return RKNN_ERR_TIMEOUT;
+    }
+    std::this_thread::sleep_until(finish);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    Context &ctx = contexts[context];
+    ctx.running = false;
+    // 推理期间输入不能被改写（零拷贝输入时NPU直接读取绑定的内存）
+    if (first_input_byte(ctx) != ctx.run_input)
+        violation("input overwritten while running");
+    return ctx.run_index == config.fail_wait_at ? -1 : 0;
+}
+
+int rknn_outputs_get(rknn_context context, uint32_t n_outputs, rknn_output outputs[], rknn_output_extend *)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Context &ctx = contexts[context];
+    records.outputs_gets++;
+    if (ctx.running)
+        violation("rknn_outputs_get while running");
+    for (uint32_t i = 0; i < n_outputs; i++)
+    {
+        if (!outputs[i].is_prealloc || outputs[i].buf == NULL)
+            return -1;
+        memset(outputs[i].buf, -128, outputs[i].size);
+    }
+    if (config.detect_class >= 0 && n_outputs == 3)
+    {
+        // 最粗尺度（步长32）第一个anchor的(0, 0)单元：box参数为0（反量化约0.5），box置信度和类别概率按配置
+        int8_t *head = (int8_t *)outputs[2].buf;
+        int grid_len = (config.in_h / 32) * (config.in_w / 32);
+        for (int c = 0; c < 4; c++)
+            head[c * grid_len] = 0;
+        head[4 * grid_len] = 127;
+        head[(5 + config.detect_class) * grid_len] = 127;
+        if (config.detect_class + 1 < config.num_classes)
+            head[(5 + config.detect_class + 1) * grid_len] = 100;
+    }
+    return 0;
+}
+
+int rknn_outputs_release(rknn_context, uint32_t, rknn_output[])
+{
+    return 0;
+}
+
+rknn_tensor_mem *rknn_create_mem(rknn_context, uint32_t size)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    rknn_tensor_mem *mem = (rknn_tensor_mem *)calloc(1, sizeof(rknn_tensor_mem));
+    mem->virt_addr = malloc(size);
+    memset(mem->virt_addr, -128, size);
+    mem->fd = -1;
+    mem->size = size;
+    records.live_mems++;
+    return mem;
+}
+
+int rknn_destroy_mem(rknn_context, rknn_tensor_mem *mem)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    free(mem->virt_addr);
+    free(mem);
+    records.live_mems--;
+    return 0;
+}
+
+int rknn_set_io_mem(rknn_context context, rknn_tensor_mem *mem, rknn_tensor_attr *attr)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Context &ctx = contexts[context];
+    if (ctx.running)
+        violation("rknn_set_io_mem while running");
+    bool input = attr->n_dims == 4 && attr->fmt == RKNN_TENSOR_NHWC && attr->dims[3] == 3;
+    if (input)
+    {
+        ctx.input_mem = mem;
+        records.input_binds++;
+        return 0;
+    }
+    if (attr->index >= 3 || (int)attr->index == config.fail_output_bind_at)
+        return -1;
+    ctx.output_mems[attr->index] = mem;
+    return 0;
+}
+
+// RGA总是不可用：预处理回退到CPU，NPU内存不导入RGA
+IM_API rga_buffer_t wrapbuffer_virtualaddr_t(void *, int, int, int, int, int)
+{
+    rga_buffer_t buf;
+    memset(&buf, 0, sizeof(buf));
+    return buf;
+}
+
+IM_API rga_buffer_t wrapbuffer_handle_t(rga_buffer_handle_t, int, int, int, int, int)
+{
+    rga_buffer_t buf;
+    memset(&buf, 0, sizeof(buf));
+    return buf;
+}
+
+IM_API rga_buffer_t wrapbuffer_handle(rga_buffer_handle_t handle, int width, int height, int format, int wstride,
+                                      int hstride)
+{
+    return wrapbuffer_handle_t(handle, width, height, wstride, hstride, format);
+}
+
+IM_API rga_buffer_t wrapbuffer_handle(rga_buffer_handle_t handle, int width, int height, int format)
+{
+    return wrapbuffer_handle_t(handle, width, height, width, height, format);
+}
+
+IM_API IM_STATUS imcheck_t(const rga_buffer_t, const rga_buffer_t, const rga_buffer_t, const im_rect, const im_rect,
+                           const im_rect, const int)
+{
+    return IM_STATUS_NOT_SUPPORTED;
+}
+
+IM_API const char *imStrError_t(IM_STATUS)
+{
+    return "rga is not available";
+}
+
+IM_API IM_STATUS improcess(rga_buffer_t, rga_buffer_t, rga_buffer_t, im_rect, im_rect, im_rect, int)
+{
+    return IM_STATUS_NOT_SUPPORTED;
+}
+
+IM_API rga_buffer_handle_t importbuffer_fd(int, int)
+{
+    return 0;
+}
+
+IM_API IM_STATUS releasebuffer_handle(rga_buffer_handle_t)
+{
+    return IM_STATUS_SUCCESS;
+}
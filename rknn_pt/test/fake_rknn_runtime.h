@@ -0,0 +1,45 @@
+#ifndef FAKE_RKNN_RUNTIME_H_
+#define FAKE_RKNN_RUNTIME_H_
+
+#include <string>
+#include <vector>
+
+// 测试用的RKNN运行时：在x86上实现RkPt用到的rknn_*接口（以及RGA接口，RGA总是不可用），模拟非阻塞rknn_run
+// 在run_ms毫秒后完成、rknn_wait等待完成的语义，记录调用顺序中违反运行时约束的地方，并可按次数注入错误。
+// 模型为单输入（NHWC、UINT8）、三个YOLOv5输出头（NCHW、INT8），输出默认全为最小量化值（没有检测结果）
+
+namespace fake_rknn
+{
+
+typedef struct _FakeConfig
+{
+    int in_h, in_w;          // 模型输入尺寸
+    int num_classes;         // 类别数
+    int run_ms;              // 每次推理的耗时
+    bool native_nhwc;        // 是否支持NHWC原生输出，否则原生输出为NC1HWC2
+    int fail_run_at;         // 第n次rknn_run（从0计，所有上下文合计）返回错误，-1为不注入
+    int fail_wait_at;        // 第n次rknn_run对应的rknn_wait返回错误，-1为不注入
+    int fail_output_bind_at; // 第n个输出的rknn_set_io_mem返回错误，-1为不注入
+    int detect_class;        // >=0时rknn_outputs_get在最粗尺度左上角单元放一个目标：该类别概率最高，
+                             // 下一个类别次之（也超过默认阈值），-1为没有目标；只写入NCHW输出
+} FakeConfig;
+
+typedef struct _FakeLog
+{
+    std::vector<int> run_inputs;       // 每次rknn_run时模型输入的第一个字节，按调用顺序
+    int input_binds;                   // rknn_set_io_mem绑定模型输入的次数
+    int outputs_gets;                  // rknn_outputs_get的调用次数
+    int waits;                         // rknn_wait的调用次数（含超时返回的）
+    int wait_timeouts;                 // rknn_wait超时返回的次数
+    int live_mems;                     // 尚未释放的rknn_create_mem内存数
+    std::vector<std::string> violations; // 违反运行时约束的调用
+} FakeLog;
+
+FakeConfig default_config();
+void reset(const FakeConfig &config); // 清空所有上下文和记录，使用新的配置
+void clear_log();                     // 只清空记录（保留上下文和未释放的内存数）
+FakeLog log();
+
+} // namespace fake_rknn
+
+#endif // FAKE_RKNN_RUNTIME_H_
@@ -0,0 +1,118 @@
+#ifndef PREPROCESS_FIXTURES_H_
+#define PREPROCESS_FIXTURES_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "det/preprocess.h"
+
+static const cv::Scalar PAD_COLOR(128, 128, 128); // 与RkPt::preprocess的填充色相同
+
+// 平滑的BGR测试图：B、G随坐标渐变，R与B相反，两种插值实现的差异小，R/B交换错误时差异很大
+inline cv::Mat gradient_image(int width, int height)
+{
+    cv::Mat img(height, width, CV_8UC3);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            cv::Vec3b &p = img.at<cv::Vec3b>(y, x);
+            p[0] = (uint8_t)(x * 255 / (width - 1));
+            p[1] = (uint8_t)(y * 255 / (height - 1));
+            p[2] = (uint8_t)(255 - p[0]);
+        }
+    }
+    return img;
+}
+
+// 与RGA逐字节比较用的用例：模型输入160x160（文件小，可以提交到仓库），覆盖缩小、放大、横竖屏、尺寸相同和拉伸
+typedef struct _GoldenCase
+{
+    int width, height; // 源图尺寸（gradient_image）
+    bool letterbox;    // 否则拉伸到整个模型输入
+} GoldenCase;
+
+static const cv::Size GOLDEN_TARGET(160, 160);
+
+inline std::vector<GoldenCase> golden_cases()
+{
+    return {{320, 180, true}, {480, 270, true}, {180, 320, true}, {80, 60, true}, {160, 160, true}, {320, 180, false}};
+}
+
+inline cv::Rect golden_roi(const GoldenCase &c)
+{
+    BOX_RECT pads;
+    float scale_w, scale_h;
+    return c.letterbox ? letterbox_rect(cv::Size(c.width, c.height), GOLDEN_TARGET, pads, scale_w, scale_h)
+                       : cv::Rect(0, 0, GOLDEN_TARGET.width, GOLDEN_TARGET.height);
+}
+
+// 捕获文件名：<宽>x<高>_<letterbox|stretch>.rgb，内容为整个模型输入（RGB，行间无填充）
+inline std::string golden_file(const std::string &dir, const GoldenCase &c)
+{
+    return dir + "/" + std::to_string(c.width) + "x" + std::to_string(c.height) +
+           (c.letterbox ? "_letterbox" : "_stretch") + ".rgb";
+}
+
+// 读取捕获的模型输入，文件不存在或大小不符返回false
+inline bool read_golden(const std::string &path, cv::Mat &input)
+{
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp)
+        return false;
+    input.create(GOLDEN_TARGET.height, GOLDEN_TARGET.width, CV_8UC3);
+    size_t row = (size_t)GOLDEN_TARGET.width * 3;
+    bool ok = true;
+    for (int y = 0; y < input.rows && ok; y++)
+        ok = fread(input.ptr(y), 1, row, fp) == row;
+    ok = ok && fgetc(fp) == EOF;
+    fclose(fp);
+    return ok;
+}
+
+inline bool write_golden(const std::string &path, const cv::Mat &input)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (!fp)
+        return false;
+    size_t row = (size_t)input.cols * 3;
+    bool ok = true;
+    for (int y = 0; y < input.rows && ok; y++)
+        ok = fwrite(input.ptr(y), 1, row, fp) == row;
+    fclose(fp);
+    return ok;
+}
+
+// 比较两幅模型输入：区域外两者都应恰好是填充色，区域内逐通道差的最大值和平均值
+inline void compare_inputs(const cv::Mat &a, const cv::Mat &b, const cv::Rect &roi, int *max_diff, double *mean_diff,
+                           long *pad_mismatch)
+{
+    long sum = 0;
+    *max_diff = 0;
+    *pad_mismatch = 0;
+    for (int y = 0; y < a.rows; y++)
+    {
+        for (int x = 0; x < a.cols; x++)
+        {
+            const cv::Vec3b &pa = a.at<cv::Vec3b>(y, x), &pb = b.at<cv::Vec3b>(y, x);
+            for (int c = 0; c < 3; c++)
+            {
+                if (roi.contains(cv::Point(x, y)))
+                {
+                    int d = abs((int)pa[c] - (int)pb[c]);
+                    *max_diff = std::max(*max_diff, d);
+                    sum += d;
+                }
+                else if (pa[c] != (uint8_t)PAD_COLOR[c] || pb[c] != (uint8_t)PAD_COLOR[c])
+                {
+                    (*pad_mismatch)++;
+                }
+            }
+        }
+    }
+    *mean_diff = roi.area() > 0 ? (double)sum / (roi.area() * 3) : 0.0;
+}
+
+#endif // PREPROCESS_FIXTURES_H_
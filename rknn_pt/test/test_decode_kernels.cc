@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "det/decode_kernels.h"
+
+// 解码内核的向量实现与标量实现逐位比较；同一份测试分别按默认指令集（aarch64为NEON，x86为SSE2）和AVX2编译
+
+#if defined(__AVX2__)
+// AVX2版本的测试在不支持AVX2的机器上跳过
+#define REQUIRE_KERNEL_ISA()                         \
+    if (!__builtin_cpu_supports("avx2"))             \
+    {                                                \
+        GTEST_SKIP() << "cpu does not support avx2"; \
+    }
+#else
+#define REQUIRE_KERNEL_ISA()
+#endif
+
+// 所有块长度和阈值下，向量扫描的位掩码与标量扫描相同（含非对齐起点和不足一个向量的尾部）
+TEST(DecodeKernels, ScanMatchesScalar)
+{
+    REQUIRE_KERNEL_ISA();
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> any(-128, 127);
+    std::vector<int8_t> buf(64 + 16);
+    for (int round = 0; round < 8; round++)
+    {
+        for (auto &v : buf)
+            v = (int8_t)any(rng);
+        // 边界值：阈值比较的两端
+        buf[3] = -128;
+        buf[17] = 127;
+        for (int start = 0; start < 16; start += 5)
+        {
+            for (int n = 0; n <= 64; n++)
+            {
+                for (int thres = -128; thres <= 127; thres++)
+                {
+                    const int8_t *p = buf.data() + start;
+                    ASSERT_EQ(scan_ge_mask64(p, n, (int8_t)thres), scan_ge_mask64_scalar(p, n, (int8_t)thres))
+                        << "start=" << start << " n=" << n << " thres=" << thres;
+                }
+            }
+        }
+    }
+}
+
+// 沿类别通道求最大值：通用版本和编译期类别数版本都与标量实现逐个相同。值只取少数几档以制造大量并列最大值
+// （并列时保留下标较小的类别），n覆盖不足一个向量、整向量和带尾部的长度，通道间距大于n（与网格长度一致）
+TEST(DecodeKernels, ArgmaxMatchesScalar)
+{
+    REQUIRE_KERNEL_ISA();
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<int> any(-128, 127), level(0, 3);
+    const int stride = 80;
+    for (int num_classes : {1, 2, 7, 10, 15, 25})
+    {
+        std::vector<int8_t> cls(num_classes * stride);
+        for (int round = 0; round < 20; round++)
+        {
+            bool ties = round % 2 == 0;
+            for (auto &v : cls)
+                v = (int8_t)(ties ? 30 * level(rng) - 45 : any(rng));
+            for (int start = 0; start < 3; start++)
+            {
+                for (int n = 0; n <= 64 && start + n <= stride; n++)
+                {
+                    const int8_t *p = cls.data() + start;
+                    std::vector<int8_t> max_ref(64), max_out(64);
+                    std::vector<uint8_t> idx_ref(64), idx_out(64);
+                    argmax_classes_block_scalar(p, stride, num_classes, n, max_ref.data(), idx_ref.data());
+
+                    argmax_classes_block(p, stride, num_classes, n, max_out.data(), idx_out.data());
+                    ASSERT_EQ(max_out, max_ref) << "nc=" << num_classes << " n=" << n << " start=" << start;
+                    ASSERT_EQ(idx_out, idx_ref) << "nc=" << num_classes << " n=" << n << " start=" << start;
+
+                    if (num_classes == 10 || num_classes == 15 || num_classes == 25)
+                    {
+                        std::fill(max_out.begin(), max_out.end(), 0);
+                        std::fill(idx_out.begin(), idx_out.end(), 0);
+                        if (num_classes == 10)
+                            argmax_classes_block_fixed<10>(p, stride, n, max_out.data(), idx_out.data());
+                        else if (num_classes == 15)
+                            argmax_classes_block_fixed<15>(p, stride, n, max_out.data(), idx_out.data());
+                        else
+                            argmax_classes_block_fixed<25>(p, stride, n, max_out.data(), idx_out.data());
+                        ASSERT_EQ(max_out, max_ref) << "fixed nc=" << num_classes << " n=" << n;
+                        ASSERT_EQ(idx_out, idx_ref) << "fixed nc=" << num_classes << " n=" << n;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 只在部分类别间求最大值：与把这些类别通道按顺序取出后的标量argmax相同，输出的是实际类别下标
+TEST(DecodeKernels, ArgmaxSubsetMatchesScalar)
+{
+    REQUIRE_KERNEL_ISA();
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> any(-128, 127), level(0, 3);
+    const int stride = 80, num_classes = 25;
+    std::vector<int8_t> cls(num_classes * stride);
+    const std::vector<std::vector<uint8_t>> subsets = {{3}, {0, 24}, {2, 5, 11, 17}, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}};
+    for (int round = 0; round < 20; round++)
+    {
+        for (auto &v : cls)
+            v = (int8_t)(round % 2 == 0 ? 30 * level(rng) - 45 : any(rng));
+        for (const auto &ids : subsets)
+        {
+            int num_ids = (int)ids.size();
+            std::vector<int8_t> gathered(num_ids * stride);
+            for (int k = 0; k < num_ids; k++)
+                std::copy(cls.begin() + ids[k] * stride, cls.begin() + (ids[k] + 1) * stride, gathered.begin() + k * stride);
+            for (int n = 0; n <= 64; n++)
+            {
+                std::vector<int8_t> max_ref(64), max_out(64);
+                std::vector<uint8_t> idx_ref(64), idx_out(64);
+                argmax_classes_block_scalar(gathered.data() + 1, stride, num_ids, n, max_ref.data(), idx_ref.data());
+                for (int c = 0; c < n; c++)
+                    idx_ref[c] = ids[idx_ref[c]];
+                argmax_classes_block_subset(cls.data() + 1, stride, ids.data(), num_ids, n, max_out.data(), idx_out.data());
+                ASSERT_EQ(max_out, max_ref) << "ids=" << num_ids << " n=" << n;
+                ASSERT_EQ(idx_out, idx_ref) << "ids=" << num_ids << " n=" << n;
+            }
+        }
+    }
+}
+
+// 全部通过或全部不通过时，掩码恰好是低n位全1或全0
+TEST(DecodeKernels, ScanAllOrNothing)
+{
+    REQUIRE_KERNEL_ISA();
+    std::vector<int8_t> hi(64, 127), lo(64, -128);
+    for (int n = 0; n <= 64; n++)
+    {
+        uint64_t full = n == 64 ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1);
+        EXPECT_EQ(scan_ge_mask64(hi.data(), n, 0), full);
+        EXPECT_EQ(scan_ge_mask64(lo.data(), n, -127), (uint64_t)0);
+        EXPECT_EQ(scan_ge_mask64(lo.data(), n, -128), full);
+    }
+}
+
+// 得分取自量化值乘积，大量候选得分相同：基数排序的结果与稳定降序排序逐个相同
+TEST(DecodeKernels, SortMatchesStableSort)
+{
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> q(160, 255);
+    for (int n : {1, 2, 63, 500, 5000})
+    {
+        std::vector<float> scores(n);
+        for (auto &s : scores)
+            s = (q(rng) / 255.f) * (q(rng) / 255.f);
+        std::vector<int> expected(n);
+        for (int i = 0; i < n; i++)
+            expected[i] = i;
+        std::stable_sort(expected.begin(), expected.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+
+        std::vector<int> order(n), order_tmp(n);
+        std::vector<uint32_t> keys(n), keys_tmp(n);
+        ASSERT_EQ(sort_scores_desc(scores.data(), n, 0, order.data(), keys.data(), keys_tmp.data(), order_tmp.data()), n);
+        EXPECT_EQ(order, expected) << "n=" << n;
+
+        // 设置候选上限时前top_k个与完整排序的前top_k个相同
+        for (int top_k : {1, 10, n / 2 + 1})
+        {
+            int kept = sort_scores_desc(scores.data(), n, top_k, order.data(), keys.data(), keys_tmp.data(),
+                                        order_tmp.data());
+            ASSERT_EQ(kept, std::min(top_k, n));
+            EXPECT_TRUE(std::equal(order.begin(), order.begin() + kept, expected.begin())) << "n=" << n << " top_k=" << top_k;
+        }
+    }
+}
+
+// 向量IoU判断与标量判断结果相同，包括并集不大于0的退化框和负阈值
+TEST(DecodeKernels, OverlapMatchesScalar)
+{
+    REQUIRE_KERNEL_ISA();
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> pos(0.f, 100.f), len(-3.f, 40.f);
+    std::uniform_int_distribution<int> cls(0, 2);
+    const int cap = 37;
+    std::vector<float> x1(cap), y1(cap), x2(cap), y2(cap), area(cap);
+    std::vector<int32_t> c(cap);
+    BoxSoA kept = {x1.data(), y1.data(), x2.data(), y2.data(), area.data(), c.data(), 0};
+    for (int round = 0; round < 2000; round++)
+    {
+        kept.count = round % cap;
+        for (int k = 0; k < kept.count; k++)
+        {
+            x1[k] = pos(rng);
+            y1[k] = pos(rng);
+            x2[k] = x1[k] + len(rng); // 宽高可能小于-1，面积为负
+            y2[k] = y1[k] + len(rng);
+            area[k] = (x2[k] - x1[k] + 1.0f) * (y2[k] - y1[k] + 1.0f);
+            c[k] = cls(rng);
+        }
+        float bx1 = pos(rng), by1 = pos(rng), bx2 = bx1 + len(rng), by2 = by1 + len(rng);
+        float barea = (bx2 - bx1 + 1.0f) * (by2 - by1 + 1.0f);
+        int32_t bcls = cls(rng);
+        for (float thres : {-0.5f, 0.f, 0.3f, 0.45f, 0.9f})
+        {
+            ASSERT_EQ(box_overlaps_any(&kept, bx1, by1, bx2, by2, barea, bcls, thres),
+                      box_overlaps_any_scalar(&kept, 0, bx1, by1, bx2, by2, barea, bcls, thres))
+                << "round=" << round << " thres=" << thres;
+        }
+    }
+}
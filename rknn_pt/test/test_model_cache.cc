@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+
+#include "det/model_cache.h"
+
+// 模型文件缓存测试：同一路径共用一份映射，视图全部释放后解除映射并删除条目，映射只读
+
+class ModelCacheTest : public ::testing::Test
+{
+protected:
+    std::string path;
+
+    void SetUp() override
+    {
+        char name[] = "/tmp/model_cache_XXXXXX";
+        int fd = mkstemp(name);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(write(fd, "rknn model", 10), 10);
+        close(fd);
+        path = name;
+    }
+
+    void TearDown() override { unlink(path.c_str()); }
+};
+
+// 同时持有的视图是同一份映射；最后一个视图释放后条目被删除，再次获取时重新映射
+TEST_F(ModelCacheTest, SharedViewAndEntryRemoval)
+{
+    ModelCache &cache = ModelCache::instance();
+    size_t before = cache.size();
+    {
+        ModelView a = cache.acquire(path);
+        ModelView b = cache.acquire(path);
+        ASSERT_TRUE(a);
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(a->size(), (size_t)10);
+        EXPECT_EQ(std::string((const char *)a->data(), 10), "rknn model");
+        EXPECT_EQ(cache.size(), before + 1);
+        a.reset();
+        EXPECT_EQ(cache.size(), before + 1); // b仍持有映射
+    }
+    EXPECT_EQ(cache.size(), before);
+
+    ModelView again = cache.acquire(path);
+    ASSERT_TRUE(again);
+    EXPECT_EQ(cache.size(), before + 1);
+    again.reset();
+    EXPECT_EQ(cache.size(), before);
+}
+
+// 打开失败的路径不留下条目
+TEST_F(ModelCacheTest, MissingFileLeavesNoEntry)
+{
+    ModelCache &cache = ModelCache::instance();
+    size_t before = cache.size();
+    for (int i = 0; i < 3; i++)
+        EXPECT_FALSE(cache.acquire(path + ".missing"));
+    EXPECT_EQ(cache.size(), before);
+}
+
+// 映射只读：写入映射的页面会段错误
+TEST_F(ModelCacheTest, MappingIsReadOnly)
+{
+    ModelView view = ModelCache::instance().acquire(path);
+    ASSERT_TRUE(view);
+    EXPECT_DEATH(*(volatile unsigned char *)view->data() = 0, "");
+}
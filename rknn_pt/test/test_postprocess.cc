@@ -0,0 +1,628 @@
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "ThreadPool.hpp"
+#include "det/postprocess.h"
+#include "decode_fixtures.h"
+
+// 后处理测试：在合成输出张量上检查解码、排序和NMS的结果
+
+// 参考解码：原来逐网格单元、逐类别扫描的process()，只推广到运行期的类别数，候选按得分稳定降序排列
+typedef struct _RefCandidate
+{
+    float x, y, w, h;
+    float score;
+    int cls;
+} RefCandidate;
+
+// classes不为空时argmax只在其中的类别（升序）间进行
+static void reference_decode(TestHeads *t, std::vector<RefCandidate> &out, const std::vector<int> &classes = {})
+{
+    out.clear();
+    const DecodeLayout &l = t->layout;
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    {
+        const HeadQuantTable &table = t->tables[h];
+        int grid_h = l.grid_h[h], grid_w = l.grid_w[h], grid_len = grid_h * grid_w, stride = l.stride[h];
+        const int *anchor = l.anchor[h];
+        int8_t thres_i8 = table.thres_i8;
+        auto deq = [&](int8_t q) { return ((float)q - (float)table.zp) * table.scale; };
+        for (int a = 0; a < OBJ_ANCHOR_NUM; a++)
+        {
+            for (int i = 0; i < grid_h; i++)
+            {
+                for (int j = 0; j < grid_w; j++)
+                {
+                    int8_t *in_ptr = t->data[h].data() + (l.prop_size * a) * grid_len + i * grid_w + j;
+                    int8_t box_confidence = in_ptr[4 * grid_len];
+                    if (box_confidence < thres_i8)
+                        continue;
+                    float box_x = deq(in_ptr[0]) * 2.0 - 0.5;
+                    float box_y = deq(in_ptr[grid_len]) * 2.0 - 0.5;
+                    float box_w = deq(in_ptr[2 * grid_len]) * 2.0;
+                    float box_h = deq(in_ptr[3 * grid_len]) * 2.0;
+                    box_x = (box_x + j) * (float)stride;
+                    box_y = (box_y + i) * (float)stride;
+                    box_w = box_w * box_w * (float)anchor[a * 2];
+                    box_h = box_h * box_h * (float)anchor[a * 2 + 1];
+                    box_x -= (box_w / 2.0);
+                    box_y -= (box_h / 2.0);
+
+                    int num_ids = classes.empty() ? l.num_classes : (int)classes.size();
+                    int maxClassId = classes.empty() ? 0 : classes[0];
+                    int8_t maxClassProbs = in_ptr[(5 + maxClassId) * grid_len];
+                    for (int n = 1; n < num_ids; ++n)
+                    {
+                        int k = classes.empty() ? n : classes[n];
+                        int8_t prob = in_ptr[(5 + k) * grid_len];
+                        if (prob > maxClassProbs)
+                        {
+                            maxClassId = k;
+                            maxClassProbs = prob;
+                        }
+                    }
+                    if (maxClassProbs > thres_i8)
+                    {
+                        RefCandidate c = {box_x, box_y, box_w, box_h, deq(maxClassProbs) * deq(box_confidence),
+                                          maxClassId};
+                        out.push_back(c);
+                    }
+                }
+            }
+        }
+    }
+    std::stable_sort(out.begin(), out.end(),
+                     [](const RefCandidate &a, const RefCandidate &b) { return a.score > b.score; });
+}
+
+// 与post_process相同的坐标换算（无填充、缩放比例为1）
+static DetectResultsGroup reference_detections(TestHeads *t, const std::vector<RefCandidate> &cands)
+{
+    DetectResultsGroup group;
+    for (const auto &c : cands)
+    {
+        auto clampi = [](float v, int lo, int hi) { return v > lo ? (v < hi ? (int)v : hi) : lo; };
+        int x1 = clampi(c.x, 0, t->in_w), y1 = clampi(c.y, 0, t->in_h);
+        int x2 = clampi(c.x + c.w, 0, t->in_w), y2 = clampi(c.y + c.h, 0, t->in_h);
+        DetectionBox box;
+        box.box = cv::Rect_<int>(x1, y1, x2 - x1, y2 - y1);
+        box.score = c.score;
+        box.obj_id = c.cls;
+        group.dets.push_back(box);
+    }
+    return group;
+}
+
+// 把NCHW输出头转换为NPU原生布局：NHWC每个网格单元占cell_step个通道，NC1HWC2按cell_step（C2）个通道分块；
+// 对齐填充的通道写入随机值，解码不应读取
+static std::vector<int8_t> to_native_layout(TestHeads *t, int h, int fmt, int cell_step, unsigned seed)
+{
+    int channels = t->layout.prop_size * OBJ_ANCHOR_NUM, grid_len = t->layout.grid_h[h] * t->layout.grid_w[h];
+    size_t size = fmt == OUTPUT_NHWC ? (size_t)grid_len * cell_step
+                                     : (size_t)((channels + cell_step - 1) / cell_step) * grid_len * cell_step;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> any(-128, 127);
+    std::vector<int8_t> out(size);
+    for (auto &v : out)
+        v = (int8_t)any(rng);
+    for (int c = 0; c < channels; c++)
+    {
+        for (int cell = 0; cell < grid_len; cell++)
+        {
+            size_t pos = fmt == OUTPUT_NHWC ? (size_t)cell * cell_step + c
+                                            : ((size_t)(c / cell_step) * grid_len + cell) * cell_step + c % cell_step;
+            out[pos] = head_at(t, h, c, cell);
+        }
+    }
+    return out;
+}
+
+class PostProcessTest : public ::testing::Test
+{
+protected:
+    TestHeads t;
+    PostProcessWorkspace ws;
+
+    void SetUp() override { memset(&ws, 0, sizeof(ws)); }
+    void TearDown() override { release_postprocess_workspace(&ws); }
+
+    void init(int in_h, int in_w, int num_classes, float conf)
+    {
+        ASSERT_EQ(init_test_heads(&t, in_h, in_w, num_classes, conf), 0);
+        ASSERT_EQ(init_postprocess_workspace(&ws, &t.layout, in_h, in_w), 0);
+    }
+};
+
+// 按块向量扫描的解码与原来逐网格单元的process()得到相同的候选、顺序和得分
+// NMS阈值取1（IoU不会大于1），输出即为全部候选，只比较解码和排序；覆盖特化的类别数和通用版本
+TEST_F(PostProcessTest, DecodeMatchesPerCellReference)
+{
+    const int class_nums[] = {10, 15, 25, 7};
+    for (int num_classes : class_nums)
+    {
+        release_postprocess_workspace(&ws);
+        init(320, 256, num_classes, 0.5f);
+        for (unsigned seed = 1; seed <= 4; seed++)
+        {
+            fill_random_heads(&t, seed * 31 + num_classes, 0.02f);
+            std::vector<RefCandidate> ref;
+            reference_decode(&t, ref);
+            ASSERT_FALSE(ref.empty());
+
+            DetectResultsGroup got;
+            run_post_process(&t, test_config(1.0f), &ws, &got);
+            EXPECT_TRUE(same_detections(got, reference_detections(&t, ref)))
+                << "classes=" << num_classes << " seed=" << seed << " got " << got.dets.size() << " expected "
+                << ref.size();
+        }
+    }
+}
+
+// 没有任何网格单元通过阈值时不产生结果
+TEST_F(PostProcessTest, EmptyFrameHasNoDetections)
+{
+    init(320, 320, 15, 0.5f);
+    DetectResultsGroup got;
+    EXPECT_EQ(run_post_process(&t, test_config(0.45f), &ws, &got), 0);
+    EXPECT_TRUE(got.dets.empty());
+}
+
+// 类别下标按uint8_t存放：类别数超过DECODE_MAX_CLASSES的输出布局被拒绝，等于上限时接受
+TEST(PostProcessLayout, RejectsTooManyClasses)
+{
+    int grid_h[OBJ_HEAD_NUM] = {80, 40, 20}, grid_w[OBJ_HEAD_NUM] = {80, 40, 20};
+    for (int num_classes : {DECODE_MAX_CLASSES, DECODE_MAX_CLASSES + 1, 300})
+    {
+        int channels[OBJ_HEAD_NUM];
+        for (int h = 0; h < OBJ_HEAD_NUM; h++)
+            channels[h] = (5 + num_classes) * OBJ_ANCHOR_NUM;
+        DecodeLayout layout;
+        EXPECT_EQ(build_decode_layout(&layout, 640, 640, channels, grid_h, grid_w),
+                  num_classes <= DECODE_MAX_CLASSES ? 0 : -1) << "num_classes=" << num_classes;
+    }
+}
+
+// 网格NMS与逐对NMS保留的框完全相同：稀疏和密集候选、超出输入范围的框、覆盖网格过多放入大框列表的框，
+// 以及同一位置大量重叠候选使单个网格链表很长的情况
+TEST_F(PostProcessTest, GridNmsMatchesPairwise)
+{
+    init(640, 640, 15, 0.3f);
+    struct Case
+    {
+        float obj_rate;
+        int wh_lo, wh_hi; // box宽高的量化值范围，越大框越大
+        bool cluster;
+    } cases[] = {
+        {0.01f, -128, 127, false}, // 稀疏
+        {0.2f, -128, 127, false},  // 密集
+        {0.05f, 60, 127, false},   // 大框：大多覆盖超过NMS_GRID_MAX_CELLS个网格，且超出输入范围
+        {0.02f, -128, -60, true},  // 小框聚集在同一区域
+    };
+    for (const Case &c : cases)
+    {
+        for (unsigned seed = 1; seed <= 3; seed++)
+        {
+            fill_random_heads(&t, seed, c.obj_rate, c.wh_lo, c.wh_hi);
+            if (c.cluster)
+                fill_dense_cluster(&t, 0, 30, 30, 6, 6);
+            for (float nms : {0.2f, 0.45f, 0.7f})
+            {
+                PostProcessConfig pairwise = test_config(nms), grid = test_config(nms);
+                grid.nms_mode = NMS_GRID;
+                DetectResultsGroup a, b;
+                {
+                    QuietStdout quiet;
+                    run_post_process(&t, pairwise, &ws, &a);
+                    run_post_process(&t, grid, &ws, &b);
+                }
+                ASSERT_FALSE(a.dets.empty());
+                EXPECT_TRUE(same_detections(a, b)) << "obj_rate=" << c.obj_rate << " wh=[" << c.wh_lo << ", "
+                                                   << c.wh_hi << "] seed=" << seed << " nms=" << nms << ": "
+                                                   << a.dets.size() << " vs " << b.dets.size();
+            }
+        }
+    }
+}
+
+// 两种NMS随候选数的耗时变化（含解码和排序），每档同时检查结果相同
+TEST_F(PostProcessTest, NmsScalingBenchmark)
+{
+    init(640, 640, 15, 0.3f);
+    const int iters = 5;
+    printf("%10s %12s %14s %12s\n", "candidates", "kept", "pairwise(ms)", "grid(ms)");
+    for (float rate : {0.005f, 0.02f, 0.05f, 0.1f, 0.2f, 0.4f})
+    {
+        fill_random_heads(&t, 3, rate, -128, 40);
+        PostProcessConfig pairwise = test_config(0.45f), grid = test_config(0.45f), all = test_config(1.0f);
+        grid.nms_mode = NMS_GRID;
+        DetectResultsGroup a, b, cand;
+        double ms[2] = {0, 0};
+        {
+            QuietStdout quiet;
+            run_post_process(&t, all, &ws, &cand);
+            for (int m = 0; m < 2; m++)
+            {
+                auto begin = std::chrono::steady_clock::now();
+                for (int i = 0; i < iters; i++)
+                    run_post_process(&t, m == 0 ? pairwise : grid, &ws, m == 0 ? &a : &b);
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+                ms[m] = elapsed.count() / iters;
+            }
+        }
+        printf("%10zu %12zu %14.3f %12.3f\n", cand.dets.size(), a.dets.size(), ms[0], ms[1]);
+        EXPECT_TRUE(same_detections(a, b)) << "rate=" << rate;
+    }
+}
+
+// 帧内并行解码：各行带写入工作区中互不重叠的区间后紧凑，候选及顺序与串行解码完全相同。
+// NMS阈值取1，输出即为全部候选；覆盖各种行带数、由粗到细解码（跳过或只解码部分最细尺度）以及行带数不整除网格行数的输入
+TEST_F(PostProcessTest, ParallelDecodeMatchesSerial)
+{
+    dpool::ThreadPool pool(4);
+    const int sizes[][2] = {{640, 640}, {480, 640}, {224, 352}};
+    for (const auto &size : sizes)
+    {
+        release_postprocess_workspace(&ws);
+        init(size[0], size[1], 15, 0.5f);
+        for (unsigned seed = 1; seed <= 3; seed++)
+        {
+            fill_random_heads(&t, seed, seed == 3 ? 0.f : 0.03f * seed);
+            for (bool coarse : {false, true})
+            {
+                PostProcessConfig serial = test_config(1.0f);
+                serial.coarse_to_fine = coarse;
+                serial.coarse_margin = 0.1f;
+                DetectResultsGroup expected;
+                {
+                    QuietStdout quiet;
+                    run_post_process(&t, serial, &ws, &expected);
+                }
+                for (int bands = 1; bands <= DECODE_MAX_BANDS; bands++)
+                {
+                    PostProcessConfig parallel = serial;
+                    parallel.decode_pool = &pool;
+                    parallel.decode_bands = bands;
+                    DetectResultsGroup got;
+                    {
+                        QuietStdout quiet;
+                        run_post_process(&t, parallel, &ws, &got);
+                    }
+                    EXPECT_TRUE(same_detections(expected, got))
+                        << size[0] << "x" << size[1] << " seed=" << seed << " coarse=" << coarse << " bands=" << bands
+                        << ": " << expected.dets.size() << " vs " << got.dets.size();
+                }
+            }
+        }
+    }
+}
+
+// 串行解码与按行带并行解码的耗时，候选上限取1使排序和NMS的耗时可以忽略；每档同时检查保留的结果相同
+TEST_F(PostProcessTest, DecodeBandsBenchmark)
+{
+    init(640, 640, 15, 0.5f);
+    dpool::ThreadPool pool(4);
+    const int iters = 50;
+    const int band_counts[] = {0, 2, 4, 8}; // 0为串行
+    printf("%10s", "obj_rate");
+    for (int bands : band_counts)
+        printf(bands ? " %8s%d(ms)" : " %13s", bands ? "bands=" : "serial(ms)", bands);
+    printf("\n");
+    for (float rate : {0.f, 0.01f, 0.05f, 0.2f})
+    {
+        fill_random_heads(&t, 5, rate);
+        DetectResultsGroup expected, got;
+        printf("%10.2f", rate);
+        for (int bands : band_counts)
+        {
+            PostProcessConfig config = test_config(0.45f);
+            config.decode_pool = bands ? &pool : NULL;
+            config.decode_bands = bands;
+            config.max_candidates = 1;
+            double ms;
+            {
+                QuietStdout quiet;
+                run_post_process(&t, config, &ws, bands ? &got : &expected); // 预热线程池
+                auto begin = std::chrono::steady_clock::now();
+                for (int i = 0; i < iters; i++)
+                    run_post_process(&t, config, &ws, bands ? &got : &expected);
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+                ms = elapsed.count() / iters;
+            }
+            printf(" %13.3f", ms);
+            if (bands)
+                EXPECT_TRUE(same_detections(expected, got)) << "rate=" << rate << " bands=" << bands;
+        }
+        printf("\n");
+    }
+}
+
+// 原生布局（通道对齐填充的NHWC、不同C2的NC1HWC2，以及各输出头布局不同）上解码得到的框与NCHW完全相同，
+// 覆盖两种NMS方式和由粗到细解码
+TEST_F(PostProcessTest, NativeLayoutMatchesNchw)
+{
+    init(640, 480, 15, 0.5f);
+    const int channels = t.layout.prop_size * OBJ_ANCHOR_NUM; // 60
+    struct Format
+    {
+        int fmt, cell_step;
+    } formats[][OBJ_HEAD_NUM] = {
+        {{OUTPUT_NHWC, channels}, {OUTPUT_NHWC, channels}, {OUTPUT_NHWC, channels}},
+        {{OUTPUT_NHWC, 64}, {OUTPUT_NHWC, 64}, {OUTPUT_NHWC, 64}},
+        {{OUTPUT_NC1HWC2, 16}, {OUTPUT_NC1HWC2, 16}, {OUTPUT_NC1HWC2, 16}},
+        {{OUTPUT_NC1HWC2, 32}, {OUTPUT_NC1HWC2, 32}, {OUTPUT_NC1HWC2, 32}},
+        {{OUTPUT_NC1HWC2, 8}, {OUTPUT_NHWC, 64}, {OUTPUT_NCHW, 1}},
+    };
+    DecodeLayout nchw_layout = t.layout;
+    for (unsigned seed = 1; seed <= 3; seed++)
+    {
+        fill_random_heads(&t, seed, 0.03f);
+        for (const auto &format : formats)
+        {
+            std::vector<int8_t> native[OBJ_HEAD_NUM];
+            int8_t *heads[OBJ_HEAD_NUM];
+            t.layout = nchw_layout;
+            for (int h = 0; h < OBJ_HEAD_NUM; h++)
+            {
+                ASSERT_EQ(set_head_format(&t.layout, h, format[h].fmt, format[h].cell_step), 0);
+                native[h] = format[h].fmt == OUTPUT_NCHW ? t.data[h]
+                                                         : to_native_layout(&t, h, format[h].fmt, format[h].cell_step, seed);
+                heads[h] = native[h].data();
+            }
+            for (int nms_mode : {NMS_PAIRWISE, NMS_GRID})
+            {
+                for (bool coarse : {false, true})
+                {
+                    PostProcessConfig config = test_config(0.45f);
+                    config.nms_mode = nms_mode;
+                    config.coarse_to_fine = coarse;
+                    config.coarse_margin = 0.1f;
+                    DetectResultsGroup expected, got;
+                    {
+                        QuietStdout quiet;
+                        run_post_process(&t, config, &ws, &got, heads);
+                        std::swap(t.layout, nchw_layout);
+                        run_post_process(&t, config, &ws, &expected);
+                        std::swap(t.layout, nchw_layout);
+                    }
+                    ASSERT_FALSE(expected.dets.empty());
+                    EXPECT_TRUE(same_detections(expected, got))
+                        << "seed=" << seed << " fmt=" << format[0].fmt << "/" << format[1].fmt << "/" << format[2].fmt
+                        << " step=" << format[0].cell_step << " nms_mode=" << nms_mode << " coarse=" << coarse;
+                }
+            }
+        }
+    }
+    t.layout = nchw_layout;
+}
+
+// 忽略区域测试用的几何：1280x960的图像letterbox到640x640的模型输入，缩放0.5，上下各填充80
+static const float IGNORE_SCALE = 0.5f;
+static BOX_RECT ignore_test_pads()
+{
+    BOX_RECT pads;
+    memset(&pads, 0, sizeof(pads));
+    pads.top = 80;
+    pads.bottom = 80;
+    return pads;
+}
+
+// 左上角的矩形和右下角的直角三角形（x + y > 2004，x < 1276，y < 956），原图坐标；
+// 网格单元中心映射回原图后坐标都是8的倍数，区域边界都不是8的倍数，中心不会落在边界上
+static IgnoreRegions ignore_test_regions()
+{
+    IgnoreRegions regions;
+    regions.rects.push_back(cv::Rect_<float>(0, 0, 404, 300));
+    regions.polygons.push_back({cv::Point2f(1276, 956), cv::Point2f(1276, 728), cv::Point2f(1048, 956)});
+    return regions;
+}
+
+static bool in_test_rect(float x, float y)
+{
+    return x >= 0 && x < 404 && y >= 0 && y < 300;
+}
+
+static bool in_test_polygon(float x, float y)
+{
+    return x + y > 2004 && x < 1276 && y < 956;
+}
+
+// 在给定填充和缩放下运行后处理
+static void run_with_geometry(TestHeads *t, const PostProcessConfig &config, PostProcessWorkspace *ws,
+                              DetectResultsGroup *group)
+{
+    post_process(t->data[0].data(), t->data[1].data(), t->data[2].data(), t->in_h, t->in_w, &config,
+                 ignore_test_pads(), IGNORE_SCALE, IGNORE_SCALE, &t->layout, t->tables, ws, group);
+}
+
+// 忽略区域位图：每个网格单元中心去掉填充、按缩放比例映射回原图后落在矩形或多边形内的单元位为0，其余为1，
+// 网格以外的位为0；矩形和多边形在每个输出头上都忽略了一部分单元
+TEST_F(PostProcessTest, IgnoreMaskMapsCellCenters)
+{
+    init(640, 640, 15, 0.5f);
+    IgnoreRegions regions = ignore_test_regions();
+    std::vector<uint64_t> masks[OBJ_HEAD_NUM];
+    int ignored = build_ignore_masks(&regions, &t.layout, ignore_test_pads(), IGNORE_SCALE, IGNORE_SCALE, masks);
+
+    int expected_ignored = 0;
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    {
+        int grid_h = t.layout.grid_h[h], grid_w = t.layout.grid_w[h], stride = t.layout.stride[h];
+        ASSERT_EQ(masks[h].size(), (size_t)(grid_h * grid_w + 63) / 64);
+        int in_rect = 0, in_polygon = 0;
+        for (int i = 0; i < grid_h; i++)
+        {
+            for (int j = 0; j < grid_w; j++)
+            {
+                float x = (j * stride + stride / 2) / IGNORE_SCALE;
+                float y = (i * stride + stride / 2 - 80) / IGNORE_SCALE;
+                bool r = in_test_rect(x, y), p = in_test_polygon(x, y);
+                in_rect += r;
+                in_polygon += p;
+                int cell = i * grid_w + j;
+                bool allowed = (masks[h][cell >> 6] >> (cell & 63)) & 1;
+                EXPECT_EQ(allowed, !(r || p)) << "head " << h << " cell " << i << "," << j;
+                expected_ignored += r || p;
+            }
+        }
+        EXPECT_GT(in_rect, 0) << "head " << h;
+        EXPECT_GT(in_polygon, 0) << "head " << h;
+        for (int cell = grid_h * grid_w; cell < (int)masks[h].size() * 64; cell++)
+            EXPECT_EQ((masks[h][cell >> 6] >> (cell & 63)) & 1, 0u);
+    }
+    EXPECT_EQ(ignored, expected_ignored);
+}
+
+// 屏蔽网格单元：结果与把这些单元的box置信度清成最小值后不屏蔽解码完全相同，即被屏蔽的单元不产生候选；
+// 由粗到细解码时粗尺度被屏蔽的单元也不计入活跃区域。空的忽略区域不改变结果
+TEST_F(PostProcessTest, IgnoreMaskRemovesMaskedCandidates)
+{
+    init(640, 640, 15, 0.5f);
+    IgnoreRegions regions = ignore_test_regions();
+    std::vector<uint64_t> masks[OBJ_HEAD_NUM], open_masks[OBJ_HEAD_NUM];
+    build_ignore_masks(&regions, &t.layout, ignore_test_pads(), IGNORE_SCALE, IGNORE_SCALE, masks);
+    IgnoreRegions none;
+    EXPECT_EQ(build_ignore_masks(&none, &t.layout, ignore_test_pads(), IGNORE_SCALE, IGNORE_SCALE, open_masks), 0);
+
+    for (unsigned seed = 1; seed <= 3; seed++)
+    {
+        for (bool coarse : {false, true})
+        {
+            for (float nms : {1.0f, 0.45f})
+            {
+                fill_random_heads(&t, seed * 7 + coarse, 0.05f);
+                PostProcessConfig config = test_config(nms);
+                config.coarse_to_fine = coarse;
+                config.coarse_margin = COARSE_MARGIN;
+
+                DetectResultsGroup unmasked, masked, open, cleared;
+                run_with_geometry(&t, config, &ws, &unmasked);
+                for (int h = 0; h < OBJ_HEAD_NUM; h++)
+                    config.cell_masks[h] = open_masks[h].data();
+                run_with_geometry(&t, config, &ws, &open);
+                for (int h = 0; h < OBJ_HEAD_NUM; h++)
+                    config.cell_masks[h] = masks[h].data();
+                run_with_geometry(&t, config, &ws, &masked);
+
+                // 参考：清掉被屏蔽单元全部anchor的box置信度，不屏蔽解码
+                for (int h = 0; h < OBJ_HEAD_NUM; h++)
+                {
+                    int grid_len = t.layout.grid_h[h] * t.layout.grid_w[h];
+                    for (int cell = 0; cell < grid_len; cell++)
+                    {
+                        if ((masks[h][cell >> 6] >> (cell & 63)) & 1)
+                            continue;
+                        for (int a = 0; a < OBJ_ANCHOR_NUM; a++)
+                            head_at(&t, h, t.layout.prop_size * a + 4, cell) = -128;
+                    }
+                    config.cell_masks[h] = NULL;
+                }
+                run_with_geometry(&t, config, &ws, &cleared);
+
+                EXPECT_TRUE(same_detections(open, unmasked)) << "seed=" << seed << " coarse=" << coarse;
+                EXPECT_TRUE(same_detections(masked, cleared))
+                    << "seed=" << seed << " coarse=" << coarse << " nms=" << nms << " got " << masked.dets.size()
+                    << " expected " << cleared.dets.size();
+                EXPECT_LT(masked.dets.size(), unmasked.dets.size());
+            }
+        }
+    }
+
+    // 粗尺度只有被屏蔽的单元通过阈值：由粗到细解码没有活跃区域，跳过最细尺度，不产生任何结果；
+    // 若粗尺度扫描不屏蔽，区域边界外附近的最细尺度单元会被解码
+    fill_random_heads(&t, 99, 1.0f);
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+    {
+        int grid_len = t.layout.grid_h[h] * t.layout.grid_w[h];
+        for (int cell = 0; cell < grid_len; cell++)
+        {
+            bool allowed = (masks[h][cell >> 6] >> (cell & 63)) & 1;
+            for (int a = 0; a < OBJ_ANCHOR_NUM; a++)
+                head_at(&t, h, t.layout.prop_size * a + 4, cell) = (h == 0 || !allowed) ? 127 : -128;
+        }
+    }
+    PostProcessConfig config = test_config(1.0f);
+    config.coarse_to_fine = true;
+    config.coarse_margin = COARSE_MARGIN;
+    for (int h = 0; h < OBJ_HEAD_NUM; h++)
+        config.cell_masks[h] = masks[h].data();
+    DetectResultsGroup masked;
+    run_with_geometry(&t, config, &ws, &masked);
+    EXPECT_TRUE(masked.dets.empty()) << masked.dets.size();
+}
+
+// 参与解码的类别列出全部类别时走子集argmax，结果与不限制类别的解码逐字节相同
+TEST_F(PostProcessTest, FullClassSubsetMatchesFullDecode)
+{
+    for (int num_classes : {10, 15, 25, 7})
+    {
+        release_postprocess_workspace(&ws);
+        init(320, 256, num_classes, 0.5f);
+        std::vector<uint8_t> all(num_classes);
+        for (int k = 0; k < num_classes; k++)
+            all[k] = (uint8_t)k;
+        for (unsigned seed = 1; seed <= 3; seed++)
+        {
+            fill_random_heads(&t, seed * 17 + num_classes, 0.05f);
+            PostProcessConfig config = test_config(0.45f);
+            DetectResultsGroup full, subset;
+            run_post_process(&t, config, &ws, &full);
+            config.active_classes = all.data();
+            config.num_active_classes = num_classes;
+            run_post_process(&t, config, &ws, &subset);
+            ASSERT_FALSE(full.dets.empty());
+            EXPECT_TRUE(same_detections(subset, full)) << "classes=" << num_classes << " seed=" << seed;
+        }
+    }
+}
+
+// 只解码两个类别：候选与argmax限制在这两个类别间的参考解码相同（NCHW按块向量argmax，NHWC逐单元argmax）
+TEST_F(PostProcessTest, ClassSubsetMatchesRestrictedReference)
+{
+    for (int num_classes : {10, 15, 25, 7})
+    {
+        release_postprocess_workspace(&ws);
+        init(320, 256, num_classes, 0.5f);
+        const std::vector<int> classes = {1, num_classes - 2};
+        const uint8_t ids[2] = {(uint8_t)classes[0], (uint8_t)classes[1]};
+        for (unsigned seed = 1; seed <= 3; seed++)
+        {
+            fill_random_heads(&t, seed * 23 + num_classes, 0.05f);
+            std::vector<RefCandidate> ref;
+            reference_decode(&t, ref, classes);
+            ASSERT_FALSE(ref.empty());
+            DetectResultsGroup expected = reference_detections(&t, ref);
+
+            PostProcessConfig config = test_config(1.0f);
+            config.active_classes = ids;
+            config.num_active_classes = 2;
+            DetectResultsGroup got;
+            run_post_process(&t, config, &ws, &got);
+            EXPECT_TRUE(same_detections(got, expected))
+                << "classes=" << num_classes << " seed=" << seed << " got " << got.dets.size() << " expected "
+                << ref.size();
+            for (const auto &det : got.dets)
+                EXPECT_TRUE(det.obj_id == classes[0] || det.obj_id == classes[1]);
+
+            // 同样的数据转换为NHWC原生布局（每个网格单元的通道按16对齐）
+            TestHeads native = t;
+            std::vector<int8_t> heads[OBJ_HEAD_NUM];
+            int8_t *head_ptrs[OBJ_HEAD_NUM];
+            int cell_step = (t.layout.prop_size * OBJ_ANCHOR_NUM + 15) / 16 * 16;
+            for (int h = 0; h < OBJ_HEAD_NUM; h++)
+            {
+                ASSERT_EQ(set_head_format(&native.layout, h, OUTPUT_NHWC, cell_step), 0);
+                heads[h] = to_native_layout(&t, h, OUTPUT_NHWC, cell_step, seed + h);
+                head_ptrs[h] = heads[h].data();
+            }
+            DetectResultsGroup got_native;
+            run_post_process(&native, config, &ws, &got_native, head_ptrs);
+            EXPECT_TRUE(same_detections(got_native, expected)) << "native classes=" << num_classes << " seed=" << seed;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+
+#include "det/postprocess.h"
+#include "decode_fixtures.h"
+
+// 后处理的内存分配测试：替换全局operator new统计分配次数，检查稳态帧（复用工作区和结果组）不分配内存。
+// 替换operator new对整个程序生效，所以单独作为一个测试目标
+
+static std::atomic<bool> counting(false);
+static std::atomic<long> allocations(0);
+
+void *operator new(size_t size)
+{
+    if (counting.load(std::memory_order_relaxed))
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// 统计一段代码中operator new的调用次数
+template <typename Func>
+static long count_allocations(Func &&func)
+{
+    allocations = 0;
+    counting = true;
+    func();
+    counting = false;
+    return allocations.load();
+}
+
+// 第一帧按最多结果数撑开结果组的容量后，之后每帧在两种NMS方式、由粗到细解码开关下都不分配内存。
+// 标签名都不超过短字符串优化的长度，写入det_name不分配；并行解码向线程池提交任务会分配，不在此列
+TEST(PostProcessAlloc, SteadyStateFramesDoNotAllocate)
+{
+    TestHeads t;
+    PostProcessWorkspace ws;
+    memset(&ws, 0, sizeof(ws));
+    ASSERT_EQ(init_test_heads(&t, 640, 640, 15, 0.3f), 0);
+    ASSERT_EQ(init_postprocess_workspace(&ws, &t.layout, 640, 640), 0);
+
+    DetectResultsGroup group;
+    QuietStdout quiet;
+    // 计数本身有效：新的结果组第一次写入结果时必然分配
+    fill_random_heads(&t, 1, 0.3f);
+    EXPECT_GT(count_allocations([&]() { run_post_process(&t, test_config(0.45f), &ws, &group); }), 0);
+    for (int nms_mode : {NMS_PAIRWISE, NMS_GRID})
+    {
+        for (bool coarse : {false, true})
+        {
+            PostProcessConfig config = test_config(0.45f);
+            config.nms_mode = nms_mode;
+            config.coarse_to_fine = coarse;
+            config.coarse_margin = 0.1f;
+            fill_random_heads(&t, 1, 0.3f);
+            run_post_process(&t, config, &ws, &group); // 撑开结果组的容量
+            size_t most = group.dets.size();
+            for (unsigned seed = 2; seed <= 6; seed++)
+            {
+                fill_random_heads(&t, seed, 0.3f * seed / 6); // 结果数不超过第一帧
+                long n = count_allocations([&]() { run_post_process(&t, config, &ws, &group); });
+                EXPECT_EQ(n, 0) << "nms_mode=" << nms_mode << " coarse=" << coarse << " seed=" << seed;
+                EXPECT_FALSE(group.dets.empty());
+                EXPECT_LE(group.dets.size(), most);
+            }
+        }
+    }
+    release_postprocess_workspace(&ws);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "det/preprocess.h"
+#include "preprocess_fixtures.h"
+
+// 预处理测试：RGA与CPU回退路径在letterbox区域内的输出在容差内一致，区域外的填充色保持不变；
+// 设置RKNN_PT_RGA_GOLDEN_DIR时把golden_cases()的RGA输出写入该目录，供preprocess-golden-test逐字节比较。
+// 需要RGA硬件，RGA不可用（imcheck或improcess失败）时跳过
+
+// 横屏、竖屏、小图放大、尺寸与模型输入相同以及拉伸模式下，RGA与CPU的输出一致
+TEST(Preprocess, RgaMatchesCpu)
+{
+    const cv::Size target(640, 640);
+    const struct
+    {
+        int width, height;
+        bool letterbox;
+    } cases[] = {
+        {1280, 720, true}, {1920, 1080, true}, {720, 1280, true}, {320, 240, true}, {640, 640, true},
+        {1280, 720, false},
+    };
+    for (const auto &c : cases)
+    {
+        cv::Mat image = gradient_image(c.width, c.height);
+        BOX_RECT pads;
+        float scale_w, scale_h;
+        cv::Rect roi = c.letterbox ? letterbox_rect(image.size(), target, pads, scale_w, scale_h)
+                                   : cv::Rect(0, 0, target.width, target.height);
+        cv::Mat rga_input(target, CV_8UC3, PAD_COLOR), cpu_input(target, CV_8UC3, PAD_COLOR);
+        if (convert_resize_rga(image, rga_input, roi) != 0)
+            GTEST_SKIP() << "rga is not available";
+        convert_resize_cpu(image, cpu_input, roi);
+
+        int max_diff;
+        double mean_diff;
+        long pad_mismatch;
+        compare_inputs(rga_input, cpu_input, roi, &max_diff, &mean_diff, &pad_mismatch);
+        EXPECT_EQ(pad_mismatch, 0) << c.width << "x" << c.height;
+        EXPECT_LE(max_diff, 12) << c.width << "x" << c.height << " letterbox=" << c.letterbox;
+        EXPECT_LE(mean_diff, 2.0) << c.width << "x" << c.height << " letterbox=" << c.letterbox;
+    }
+}
+
+// 捕获RGA的输出：RKNN_PT_RGA_GOLDEN_DIR指向test/data/rga_golden时，在板上运行一次即可更新仓库中的比较基准
+TEST(Preprocess, CaptureRgaGolden)
+{
+    const char *dir = getenv("RKNN_PT_RGA_GOLDEN_DIR");
+    if (dir == NULL)
+        GTEST_SKIP() << "RKNN_PT_RGA_GOLDEN_DIR is not set";
+    for (const GoldenCase &c : golden_cases())
+    {
+        cv::Mat input(GOLDEN_TARGET, CV_8UC3, PAD_COLOR);
+        if (convert_resize_rga(gradient_image(c.width, c.height), input, golden_roi(c)) != 0)
+            GTEST_SKIP() << "rga is not available";
+        std::string path = golden_file(dir, c);
+        ASSERT_TRUE(write_golden(path, input)) << path;
+        printf("captured %s\n", path.c_str());
+    }
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "det/preprocess.h"
+#include "preprocess_fixtures.h"
+
+// CPU回退路径与RGA逐字节比较：基准是板上preprocess-test的CaptureRgaGolden写出的RGA输出（test/data/rga_golden），
+// 不需要RGA硬件，x86上也运行。基准文件缺失时跳过逐字节比较，只检查与插值无关的部分
+
+#ifndef RGA_GOLDEN_DIR
+#define RGA_GOLDEN_DIR "test/data/rga_golden"
+#endif
+
+// 每个用例的CPU输出与捕获的RGA输出逐字节相同（包括填充区域）
+TEST(PreprocessGolden, CpuMatchesRgaCapture)
+{
+    std::vector<std::string> missing;
+    for (const GoldenCase &c : golden_cases())
+    {
+        cv::Mat golden;
+        if (!read_golden(golden_file(RGA_GOLDEN_DIR, c), golden))
+            missing.push_back(golden_file(RGA_GOLDEN_DIR, c));
+    }
+    if (!missing.empty())
+        GTEST_SKIP() << missing.size() << " rga captures missing (first " << missing[0]
+                     << "); run preprocess-test on the board with RKNN_PT_RGA_GOLDEN_DIR=" << RGA_GOLDEN_DIR;
+
+    for (const GoldenCase &c : golden_cases())
+    {
+        cv::Mat golden, input(GOLDEN_TARGET, CV_8UC3, PAD_COLOR);
+        ASSERT_TRUE(read_golden(golden_file(RGA_GOLDEN_DIR, c), golden));
+        cv::Rect roi = golden_roi(c);
+        convert_resize_cpu(gradient_image(c.width, c.height), input, roi);
+
+        int max_diff;
+        double mean_diff;
+        long pad_mismatch;
+        compare_inputs(golden, input, roi, &max_diff, &mean_diff, &pad_mismatch);
+        EXPECT_EQ(pad_mismatch, 0) << c.width << "x" << c.height;
+        EXPECT_EQ(max_diff, 0) << c.width << "x" << c.height << " letterbox=" << c.letterbox << " mean " << mean_diff;
+    }
+}
+
+// 源图与区域尺寸相同时不缩放，RGA只做R/B交换，CPU输出必须是源图逐像素交换R/B，区域外保持填充色
+TEST(PreprocessGolden, SameSizeIsChannelSwap)
+{
+    GoldenCase c = {GOLDEN_TARGET.width, GOLDEN_TARGET.height, true};
+    cv::Mat image = gradient_image(c.width, c.height);
+    cv::Mat input(GOLDEN_TARGET, CV_8UC3, PAD_COLOR);
+    cv::Rect roi = golden_roi(c);
+    ASSERT_EQ(roi, cv::Rect(0, 0, c.width, c.height));
+    convert_resize_cpu(image, input, roi);
+    for (int y = 0; y < image.rows; y++)
+    {
+        for (int x = 0; x < image.cols; x++)
+        {
+            const cv::Vec3b &s = image.at<cv::Vec3b>(y, x), &d = input.at<cv::Vec3b>(y, x);
+            ASSERT_EQ(d[0], s[2]) << x << "," << y;
+            ASSERT_EQ(d[1], s[1]) << x << "," << y;
+            ASSERT_EQ(d[2], s[0]) << x << "," << y;
+        }
+    }
+
+    // 宽与区域相同、高不同的letterbox：只写区域内，区域外每个字节保持填充色
+    GoldenCase wide = {GOLDEN_TARGET.width, GOLDEN_TARGET.height / 2, true};
+    cv::Mat padded(GOLDEN_TARGET, CV_8UC3, PAD_COLOR);
+    cv::Rect wide_roi = golden_roi(wide);
+    ASSERT_EQ(wide_roi.width, wide.width);
+    ASSERT_EQ(wide_roi.height, wide.height);
+    convert_resize_cpu(gradient_image(wide.width, wide.height), padded, wide_roi);
+    long pad_mismatch = 0;
+    for (int y = 0; y < padded.rows; y++)
+    {
+        for (int x = 0; x < padded.cols; x++)
+        {
+            const cv::Vec3b &p = padded.at<cv::Vec3b>(y, x);
+            if (!wide_roi.contains(cv::Point(x, y)))
+                pad_mismatch += (p[0] != 128) + (p[1] != 128) + (p[2] != 128);
+        }
+    }
+    EXPECT_EQ(pad_mismatch, 0);
+}
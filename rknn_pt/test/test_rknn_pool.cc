@@ -0,0 +1,363 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rknnPool.hpp"
+
+// 桩模型：不依赖NPU，模拟RkPt的异步接口。每个上下文的"NPU"串行执行任务：任务在前一个任务完成后开始，
+// 运行输入给定的毫秒数；submit先睡眠preMs模拟预处理。用于在x86上检查模型池的派发、重排序和交付
+
+typedef struct _StubInput
+{
+    int sleepMs; // 模拟的推理耗时
+    int preMs;   // 模拟的预处理耗时，在submit中
+} StubInput;
+
+typedef struct _StubOutput
+{
+    int frameId;
+} StubOutput;
+
+class StubModel
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+    struct Job
+    {
+        int frameId;
+        Clock::time_point finish; // 模拟的NPU完成时间
+    };
+
+    int ctx;
+    std::mutex mtx;
+    std::deque<Job> jobs;
+
+public:
+    std::atomic<int> maxJobs; // 同时未取回任务数的最大值
+
+    StubModel(const char *) : ctx(0), maxJobs(0) {}
+    int init(int *, bool) { return 0; }
+    int *get_pctx() { return &ctx; }
+
+    int submit(const StubInput &input, int frameId)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(input.preMs));
+        std::lock_guard<std::mutex> lock(mtx);
+        if ((int)jobs.size() >= CONTEXT_JOBS)
+            return -1;
+        Clock::time_point begin = jobs.empty() ? Clock::now() : std::max(Clock::now(), jobs.back().finish);
+        Job job = {frameId, begin + std::chrono::milliseconds(input.sleepMs)};
+        jobs.push_back(job);
+        maxJobs = std::max(maxJobs.load(), (int)jobs.size());
+        return 0;
+    }
+
+    int wait(StubOutput &out)
+    {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (jobs.empty())
+                return -1;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+        std::this_thread::sleep_until(job.finish);
+        out.frameId = job.frameId;
+        return job.frameId < 0 ? -1 : 0; // 负帧号模拟推理出错
+    }
+};
+
+typedef rknnPool<StubModel, StubInput, StubOutput> StubPool;
+
+// 回调中记录交付的帧号
+struct Collector
+{
+    std::mutex mtx;
+    std::vector<int> ids;
+
+    StubPool::ResultCallback callback()
+    {
+        return [this](StubOutput &out)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            ids.push_back(out.frameId);
+        };
+    }
+};
+
+// 耗时交错的帧在流水线中乱序完成，按帧号顺序交付且不丢帧
+TEST(RknnPool, PipelineDeliversInFrameOrder)
+{
+    Collector collector;
+    {
+        StubPool pool("stub", 3);
+        ASSERT_EQ(pool.init(), 0);
+        pool.set_pipeline(3, collector.callback(), DELIVER_IN_ORDER);
+        for (int i = 0; i < 30; i++)
+        {
+            StubInput input = {(i % 3 == 0) ? 15 : 1, 0}; // 每三帧中第一帧最慢，后两帧先完成
+            ASSERT_EQ(pool.put(input, i), 0);
+        }
+    } // 析构等待全部交付
+
+    ASSERT_EQ((int)collector.ids.size(), 30);
+    for (int i = 0; i < 30; i++)
+        EXPECT_EQ(collector.ids[i], i);
+}
+
+// 最新结果优先：交付的帧号严格递增，交付数与丢弃的过期结果数之和等于提交数
+TEST(RknnPool, LatestModeDropsStaleResults)
+{
+    Collector collector;
+    PoolStats stats;
+    {
+        StubPool pool("stub", 3);
+        ASSERT_EQ(pool.init(), 0);
+        pool.set_pipeline(3, collector.callback(), DELIVER_LATEST);
+        for (int i = 0; i < 30; i++)
+        {
+            StubInput input = {(i % 3 == 0) ? 15 : 1, 0};
+            ASSERT_EQ(pool.put(input, i), 0);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        stats = pool.get_stats();
+    }
+
+    ASSERT_FALSE(collector.ids.empty());
+    for (size_t i = 1; i < collector.ids.size(); i++)
+        EXPECT_LT(collector.ids[i - 1], collector.ids[i]);
+    EXPECT_EQ(collector.ids.back(), 29);
+    EXPECT_EQ(stats.submitted, 30);
+    EXPECT_EQ(stats.delivered + stats.staleDropped, 30);
+    EXPECT_EQ((long long)collector.ids.size(), stats.delivered);
+}
+
+// 阻塞式get：每帧put后get，得到的就是这一帧
+TEST(RknnPool, BlockingGetReturnsEachFrame)
+{
+    StubPool pool("stub", 2);
+    ASSERT_EQ(pool.init(), 0);
+    for (int i = 0; i < 5; i++)
+    {
+        StubInput input = {1, 0};
+        ASSERT_EQ(pool.put(input, i), 0);
+        StubOutput out = {-1};
+        ASSERT_EQ(pool.get(out), 0);
+        EXPECT_EQ(out.frameId, i);
+    }
+}
+
+// 多个上下文同时推理：N个上下文处理固定耗时的帧，总耗时明显小于串行
+TEST(RknnPool, PipelineOverlapsContexts)
+{
+    const int contexts = 3, frames = 12, sleepMs = 20;
+    Collector collector;
+    auto begin = std::chrono::steady_clock::now();
+    {
+        StubPool pool("stub", contexts);
+        ASSERT_EQ(pool.init(), 0);
+        pool.set_pipeline(contexts, collector.callback(), DELIVER_IN_ORDER);
+        for (int i = 0; i < frames; i++)
+        {
+            StubInput input = {sleepMs, 0};
+            ASSERT_EQ(pool.put(input, i), 0);
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    EXPECT_EQ((int)collector.ids.size(), frames);
+    EXPECT_LT(ms, frames * sleepMs * 0.75);
+}
+
+// 交付进行中析构：析构返回前交付线程已退出，反复创建销毁不应访问已销毁的条件变量
+TEST(RknnPool, DestroyWhileDelivering)
+{
+    for (int round = 0; round < 50; round++)
+    {
+        std::atomic<int> delivered(0);
+        {
+            StubPool pool("stub", 2);
+            ASSERT_EQ(pool.init(), 0);
+            pool.set_pipeline(2, [&delivered](StubOutput &) { delivered++; }, DELIVER_IN_ORDER);
+            for (int i = 0; i < 4; i++)
+            {
+                StubInput input = {0, 0};
+                ASSERT_EQ(pool.put(input, i), 0);
+            }
+        }
+        EXPECT_EQ(delivered.load(), 4);
+    }
+}
+
+// 单个上下文：每帧的预处理（submit）与前一帧的推理重叠，总耗时接近 帧数 × max(预处理, 推理)，
+// 同时未取回的任务不超过CONTEXT_JOBS
+TEST(RknnPool, SingleContextOverlapsSubmitWithRun)
+{
+    const int frames = 12, preMs = 10, sleepMs = 10;
+    Collector collector;
+    int maxJobs = 0;
+    auto begin = std::chrono::steady_clock::now();
+    {
+        StubPool pool("stub", 1);
+        ASSERT_EQ(pool.init(), 0);
+        pool.set_pipeline(0, collector.callback(), DELIVER_IN_ORDER);
+        for (int i = 0; i < frames; i++)
+        {
+            StubInput input = {sleepMs, preMs};
+            ASSERT_EQ(pool.put(input, i), 0);
+        }
+        pool.for_each_model([&maxJobs](StubModel *model) { maxJobs = model->maxJobs; });
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    ASSERT_EQ((int)collector.ids.size(), frames);
+    for (int i = 0; i < frames; i++)
+        EXPECT_EQ(collector.ids[i], i);
+    EXPECT_EQ(maxJobs, CONTEXT_JOBS);
+    EXPECT_LT(ms, frames * (preMs + sleepMs) * 0.8);
+}
+
+// 推理出错的帧不交付，不阻塞后面的帧
+TEST(RknnPool, FailedFrameIsSkipped)
+{
+    Collector collector;
+    PoolStats stats;
+    {
+        StubPool pool("stub", 2);
+        ASSERT_EQ(pool.init(), 0);
+        pool.set_pipeline(0, collector.callback(), DELIVER_IN_ORDER);
+        for (int i = -1; i < 6; i++)
+        {
+            StubInput input = {2, 0};
+            ASSERT_EQ(pool.put(input, i), 0);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        stats = pool.get_stats();
+    }
+    ASSERT_EQ((int)collector.ids.size(), 6);
+    for (int i = 0; i < 6; i++)
+        EXPECT_EQ(collector.ids[i], i);
+    EXPECT_EQ(stats.submitted, 7);
+    EXPECT_EQ(stats.inFlight, 0);
+}
+
+// 过载的单上下文模型池：每帧推理sleepMs，连续放入frames帧，在途上限CONTEXT_JOBS、准入队列容量queueCap；
+// 返回每次put的返回值，collector记录交付的帧号，stats为析构前（全部交付后）的统计
+static std::vector<int> overload(AdmissionPolicy policy, int frames, int queueCap, int sleepMs, Collector &collector,
+                                 PoolStats &stats, std::vector<double> *putMs = nullptr)
+{
+    std::vector<int> rets;
+    StubPool pool("stub", 1);
+    EXPECT_EQ(pool.init(), 0);
+    pool.set_pipeline(0, collector.callback(), DELIVER_IN_ORDER);
+    pool.set_admission(queueCap, policy);
+    for (int i = 0; i < frames; i++)
+    {
+        StubInput input = {sleepMs, 0};
+        auto begin = std::chrono::steady_clock::now();
+        rets.push_back(pool.put(input, i));
+        if (putMs)
+            putMs->push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+    }
+    while (pool.get_stats().inFlight > 0 || pool.get_stats().queued > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    stats = pool.get_stats();
+    return rets;
+}
+
+// 丢弃新帧：在途和准入队列都满后put返回1并计数，交付的是最早进入的帧
+TEST(RknnPool, AdmissionDropNewest)
+{
+    const int frames = 10, queueCap = 2;
+    Collector collector;
+    PoolStats stats;
+    std::vector<int> rets = overload(ADMIT_DROP_NEWEST, frames, queueCap, 20, collector, stats);
+
+    int kept = CONTEXT_JOBS + queueCap;
+    for (int i = 0; i < frames; i++)
+        EXPECT_EQ(rets[i], i < kept ? 0 : 1) << "frame " << i;
+    EXPECT_EQ(stats.droppedNewest, frames - kept);
+    EXPECT_EQ(stats.droppedOldest, 0);
+    EXPECT_EQ(stats.submitted + stats.droppedNewest + stats.droppedOldest, frames);
+    ASSERT_EQ((int)collector.ids.size(), kept);
+    for (int i = 0; i < kept; i++)
+        EXPECT_EQ(collector.ids[i], i);
+}
+
+// 丢弃旧帧：准入队列中最旧的帧被新帧替换，交付的是已在推理的帧和最新的queueCap帧；
+// 每帧从put到交付的延迟不超过（在途上限 + 队列容量）帧的推理时间加余量
+TEST(RknnPool, AdmissionDropOldestKeepsNewest)
+{
+    const int frames = 10, queueCap = 2, sleepMs = 20;
+    Collector collector;
+    PoolStats stats;
+    std::vector<std::chrono::steady_clock::time_point> putAt(frames), deliveredAt(frames);
+    std::mutex mtx;
+    {
+        StubPool pool("stub", 1);
+        ASSERT_EQ(pool.init(), 0);
+        pool.set_pipeline(0, [&](StubOutput &out)
+                          {
+                              std::lock_guard<std::mutex> lock(mtx);
+                              collector.ids.push_back(out.frameId);
+                              deliveredAt[out.frameId] = std::chrono::steady_clock::now();
+                          }, DELIVER_IN_ORDER);
+        pool.set_admission(queueCap, ADMIT_DROP_OLDEST);
+        for (int i = 0; i < frames; i++)
+        {
+            StubInput input = {sleepMs, 0};
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                putAt[i] = std::chrono::steady_clock::now();
+            }
+            ASSERT_EQ(pool.put(input, i), 0);
+        }
+        while (pool.get_stats().inFlight > 0 || pool.get_stats().queued > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        stats = pool.get_stats();
+    }
+
+    std::vector<int> expected;
+    for (int i = 0; i < CONTEXT_JOBS; i++)
+        expected.push_back(i);
+    for (int i = frames - queueCap; i < frames; i++)
+        expected.push_back(i);
+    EXPECT_EQ(collector.ids, expected);
+    EXPECT_EQ(stats.droppedOldest, frames - CONTEXT_JOBS - queueCap);
+    EXPECT_EQ(stats.droppedNewest, 0);
+    EXPECT_EQ(stats.submitted + stats.droppedNewest + stats.droppedOldest, frames);
+    for (int id : collector.ids)
+    {
+        double ms = std::chrono::duration<double, std::milli>(deliveredAt[id] - putAt[id]).count();
+        EXPECT_LT(ms, (CONTEXT_JOBS + queueCap + 1) * sleepMs) << "frame " << id;
+    }
+}
+
+// 阻塞：队列满后put等到有帧取回、队列腾出空位才返回，不丢帧
+TEST(RknnPool, AdmissionBlockWaitsForSlot)
+{
+    const int frames = 8, queueCap = 2, sleepMs = 20;
+    Collector collector;
+    PoolStats stats;
+    std::vector<double> putMs;
+    std::vector<int> rets = overload(ADMIT_BLOCK, frames, queueCap, sleepMs, collector, stats, &putMs);
+
+    int kept = CONTEXT_JOBS + queueCap;
+    for (int i = 0; i < frames; i++)
+    {
+        EXPECT_EQ(rets[i], 0);
+        if (i < kept)
+            EXPECT_LT(putMs[i], sleepMs / 2) << "frame " << i; // 有空位时立即返回
+        else
+            EXPECT_GT(putMs[i], sleepMs / 2) << "frame " << i; // 等前面的一帧取回
+    }
+    EXPECT_EQ(stats.droppedNewest + stats.droppedOldest, 0);
+    EXPECT_EQ(stats.submitted, frames);
+    ASSERT_EQ((int)collector.ids.size(), frames);
+    for (int i = 0; i < frames; i++)
+        EXPECT_EQ(collector.ids[i], i);
+}
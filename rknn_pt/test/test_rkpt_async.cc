@@ -0,0 +1,365 @@
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+#include "det/rkpt.hpp"
+#include "rknnPool.hpp"
+#include "fake_rknn_runtime.h"
+
+// RkPt异步接口测试：链接测试用的RKNN运行时（fake_rknn_runtime.cc）代替librknnrt，在x86上检查
+// submit/wait的启动顺序、输入槽复用、错误只影响出错的任务，以及模型池驱动上下文时的交付顺序和rknn_wait次数
+
+class RkPtAsync : public ::testing::Test
+{
+protected:
+    std::string model_path;
+
+    void SetUp() override { SetUpRuntime(fake_rknn::default_config()); }
+
+    // 按配置重置测试运行时并重新生成模型文件：文件只需存在且非空，内容由测试运行时忽略
+    void SetUpRuntime(const fake_rknn::FakeConfig &config)
+    {
+        TearDown();
+        fake_rknn::reset(config);
+        char path[] = "/tmp/rkpt_async_XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(write(fd, "rknn", 4), 4);
+        close(fd);
+        model_path = path;
+    }
+
+    void TearDown() override
+    {
+        if (!model_path.empty())
+            unlink(model_path.c_str());
+        model_path.clear();
+    }
+
+    // 初始化一个上下文，预处理走CPU
+    void init_model(RkPt &model)
+    {
+        ASSERT_EQ(model.init(model.get_pctx(), false), 0);
+        model.set_rga_preprocess(false);
+    }
+};
+
+// 模型输入尺寸的纯色帧，像素值10+id：运行时在rknn_run时记录输入的第一个字节，由此知道启动的是哪一帧
+static FramePtr test_frame(int id)
+{
+    fake_rknn::FakeConfig config = fake_rknn::default_config();
+    return make_frame(cv::Mat(config.in_h, config.in_w, CV_8UC3, cv::Scalar(10 + id, 10 + id, 10 + id)));
+}
+
+static std::vector<int> frame_values(int begin, int end)
+{
+    std::vector<int> values;
+    for (int id = begin; id < end; id++)
+        values.push_back(10 + id);
+    return values;
+}
+
+// 两帧在途：按提交顺序启动和取回，前一帧运行时提交的下一帧等前一帧取回输出后才启动
+TEST_F(RkPtAsync, SubmitWaitKeepsOrder)
+{
+    const int frames = 8;
+    {
+        RkPt model(model_path);
+        init_model(model);
+        ASSERT_EQ(model.submit(test_frame(0), 0), 0);
+        ASSERT_EQ(model.submit(test_frame(1), 1), 0);
+        EXPECT_EQ(model.submit(test_frame(2), 2), -1); // 已有INFER_SLOTS个未取回的任务
+        for (int id = 0; id < frames; id++)
+        {
+            DetectResultsGroup result;
+            ASSERT_EQ(model.wait(result), 0);
+            EXPECT_EQ(result.cur_frame_id, id);
+            EXPECT_TRUE(result.dets.empty());
+            if (id + 2 < frames)
+                ASSERT_EQ(model.submit(test_frame(id + 2), id + 2), 0);
+        }
+        DetectResultsGroup result;
+        EXPECT_EQ(model.wait(result), -1);
+        EXPECT_EQ(model.pending(), 0);
+    }
+    fake_rknn::FakeLog log = fake_rknn::log();
+    EXPECT_EQ(log.run_inputs, frame_values(0, frames));
+    EXPECT_EQ(log.outputs_gets, frames);
+    EXPECT_TRUE(log.violations.empty()) << log.violations[0];
+}
+
+// poll不阻塞：推理未完成时返回0，完成后返回1，之后wait直接取回
+TEST_F(RkPtAsync, PollReportsCompletion)
+{
+    fake_rknn::FakeConfig config = fake_rknn::default_config();
+    config.run_ms = 30;
+    SetUpRuntime(config);
+    RkPt model(model_path);
+    init_model(model);
+    EXPECT_EQ(model.poll(), -1);
+    ASSERT_EQ(model.submit(test_frame(0), 0), 0);
+    EXPECT_EQ(model.poll(), 0);
+    int polls = 0;
+    while (model.poll() == 0)
+        polls++;
+    EXPECT_GT(polls, 0);
+    DetectResultsGroup result;
+    EXPECT_EQ(model.wait(result), 0);
+    EXPECT_EQ(result.cur_frame_id, 0);
+    EXPECT_TRUE(fake_rknn::log().violations.empty());
+}
+
+// 零拷贝输入：逐帧串行时一直使用绑定的槽，不重新绑定；两帧在途时换槽绑定，运行中的输入不被下一帧覆盖
+TEST_F(RkPtAsync, ZeroCopyReusesBoundSlot)
+{
+    {
+        RkPt model(model_path);
+        init_model(model);
+        ASSERT_EQ(model.enable_zero_copy_input(), 0);
+        fake_rknn::clear_log();
+
+        for (int id = 0; id < 5; id++)
+        {
+            DetectResultsGroup result;
+            ASSERT_EQ(model.submit(test_frame(id), id), 0);
+            ASSERT_EQ(model.wait(result), 0);
+            EXPECT_EQ(result.cur_frame_id, id);
+        }
+        EXPECT_EQ(fake_rknn::log().input_binds, 1);
+
+        ASSERT_EQ(model.submit(test_frame(5), 5), 0);
+        for (int id = 5; id < 10; id++)
+        {
+            if (id + 1 < 10)
+                ASSERT_EQ(model.submit(test_frame(id + 1), id + 1), 0);
+            DetectResultsGroup result;
+            ASSERT_EQ(model.wait(result), 0);
+            EXPECT_EQ(result.cur_frame_id, id);
+        }
+        EXPECT_GT(fake_rknn::log().input_binds, 1);
+    }
+    fake_rknn::FakeLog log = fake_rknn::log();
+    EXPECT_EQ(log.run_inputs, frame_values(0, 10));
+    EXPECT_TRUE(log.violations.empty()) << log.violations[0];
+    EXPECT_EQ(log.live_mems, 0);
+}
+
+// 按提交顺序取回frames帧，两帧在途，返回每帧wait的返回值
+static std::vector<int> run_pipelined(RkPt &model, int frames)
+{
+    std::vector<int> status;
+    model.submit(test_frame(0), 0);
+    for (int id = 0; id < frames; id++)
+    {
+        if (id + 1 < frames)
+            model.submit(test_frame(id + 1), id + 1);
+        DetectResultsGroup result;
+        status.push_back(model.wait(result));
+        EXPECT_EQ(result.cur_frame_id, id);
+    }
+    return status;
+}
+
+// rknn_wait出错：只有该帧返回-1，排在它后面的帧照常启动和取回
+TEST_F(RkPtAsync, WaitErrorFailsOnlyItsJob)
+{
+    fake_rknn::FakeConfig config = fake_rknn::default_config();
+    config.fail_wait_at = 1;
+    SetUpRuntime(config);
+    {
+        RkPt model(model_path);
+        init_model(model);
+        EXPECT_EQ(run_pipelined(model, 4), std::vector<int>({0, -1, 0, 0}));
+    }
+    fake_rknn::FakeLog log = fake_rknn::log();
+    EXPECT_EQ(log.run_inputs, frame_values(0, 4));
+    EXPECT_TRUE(log.violations.empty()) << log.violations[0];
+}
+
+// rknn_run出错：该帧没有启动，wait返回-1；后面的帧在它取回时启动
+TEST_F(RkPtAsync, RunErrorFailsOnlyItsJob)
+{
+    fake_rknn::FakeConfig config = fake_rknn::default_config();
+    config.fail_run_at = 2;
+    SetUpRuntime(config);
+    {
+        RkPt model(model_path);
+        init_model(model);
+        EXPECT_EQ(run_pipelined(model, 5), std::vector<int>({0, 0, -1, 0, 0}));
+    }
+    fake_rknn::FakeLog log = fake_rknn::log();
+    EXPECT_EQ(log.run_inputs, std::vector<int>({10, 11, 13, 14}));
+    EXPECT_TRUE(log.violations.empty()) << log.violations[0];
+}
+
+// 原生布局输出（NHWC和NC1HWC2）：结果直接写入绑定的内存，不再调用rknn_outputs_get
+TEST_F(RkPtAsync, NativeOutputSkipsOutputsGet)
+{
+    for (bool nhwc : {true, false})
+    {
+        fake_rknn::FakeConfig config = fake_rknn::default_config();
+        config.native_nhwc = nhwc;
+        SetUpRuntime(config);
+        {
+            RkPt model(model_path);
+            init_model(model);
+            ASSERT_EQ(model.enable_native_output(), 0);
+            EXPECT_EQ(run_pipelined(model, 6), std::vector<int>(6, 0));
+        }
+        fake_rknn::FakeLog log = fake_rknn::log();
+        EXPECT_EQ(log.run_inputs, frame_values(0, 6));
+        EXPECT_EQ(log.outputs_gets, 0);
+        EXPECT_EQ(log.live_mems, 0);
+        EXPECT_TRUE(log.violations.empty()) << log.violations[0];
+    }
+}
+
+// 第一个输出就绑定失败：没有输出改变，保持NCHW输出继续推理；已创建的内存全部释放
+TEST_F(RkPtAsync, NativeOutputFailureKeepsNchw)
+{
+    fake_rknn::FakeConfig config = fake_rknn::default_config();
+    config.fail_output_bind_at = 0;
+    SetUpRuntime(config);
+    {
+        RkPt model(model_path);
+        init_model(model);
+        EXPECT_EQ(model.enable_native_output(), -1);
+        EXPECT_EQ(fake_rknn::log().live_mems, 0);
+        EXPECT_EQ(run_pipelined(model, 3), std::vector<int>(3, 0));
+    }
+    fake_rknn::FakeLog log = fake_rknn::log();
+    EXPECT_EQ(log.outputs_gets, 3);
+    EXPECT_TRUE(log.violations.empty()) << log.violations[0];
+}
+
+// 部分输出已绑定后失败：无法恢复NCHW输出，该上下文不再接受任务，内存不泄漏
+TEST_F(RkPtAsync, PartialNativeBindDisablesContext)
+{
+    fake_rknn::FakeConfig config = fake_rknn::default_config();
+    config.fail_output_bind_at = 1;
+    SetUpRuntime(config);
+    {
+        RkPt model(model_path);
+        init_model(model);
+        EXPECT_EQ(model.enable_native_output(), -2);
+        EXPECT_EQ(fake_rknn::log().live_mems, 0);
+        EXPECT_EQ(model.submit(test_frame(0), 0), -1);
+        DetectResultsGroup result = model.infer(test_frame(1), 1);
+        EXPECT_TRUE(result.dets.empty());
+    }
+    fake_rknn::FakeLog log = fake_rknn::log();
+    EXPECT_TRUE(log.run_inputs.empty());
+    EXPECT_EQ(log.live_mems, 0);
+}
+
+// 参与解码的类别：设置忽略区域后仍可设置（曾因忽略区域重置类别数而全部被拒绝），之后再设置忽略区域也不清除；
+// 运行时输出一个目标，类别3概率最高、类别4次之
+TEST_F(RkPtAsync, ActiveClassesAfterIgnoreRegions)
+{
+    fake_rknn::FakeConfig config = fake_rknn::default_config();
+    config.detect_class = 3;
+    SetUpRuntime(config);
+    RkPt model(model_path);
+    init_model(model);
+    IgnoreRegions regions;
+    regions.rects.push_back(cv::Rect_<float>(40, 40, 20, 20)); // 右下角，不覆盖目标所在的单元
+    auto detect = [&model](int id)
+    {
+        DetectResultsGroup result = model.infer(test_frame(id), id);
+        return result.dets.size() == 1 ? result.dets[0].obj_id : -(int)result.dets.size() - 1;
+    };
+
+    EXPECT_EQ(detect(0), 3);
+    model.set_ignore_regions(regions);
+    ASSERT_EQ(model.set_active_classes({4, 9}), 0);
+    EXPECT_EQ(model.get_num_classes(), config.num_classes);
+    EXPECT_EQ(detect(1), 4);
+    EXPECT_EQ(model.set_active_classes({config.num_classes}), -1); // 越界，保持原设置
+    EXPECT_EQ(detect(2), 4);
+    model.set_ignore_regions(regions);
+    EXPECT_EQ(detect(3), 4);
+    ASSERT_EQ(model.set_active_classes({9}), 0);
+    EXPECT_EQ(detect(4), -1); // 只解码类别9，没有结果
+    ASSERT_EQ(model.set_active_classes({}), 0);
+    EXPECT_EQ(detect(5), 3);
+    EXPECT_TRUE(fake_rknn::log().violations.empty());
+}
+
+typedef rknnPool<RkPt, FramePtr, DetectResultsGroup> RkPtPool;
+
+// 模型池驱动两个上下文：每个上下文两帧在途（其中一个开启零拷贝输入），按帧号顺序交付，
+// 每帧只启动一次，没有违反运行时约束的调用
+TEST_F(RkPtAsync, PoolDeliversInOrder)
+{
+    const int frames = 40;
+    std::vector<int> ids;
+    std::mutex mtx;
+    {
+        RkPtPool pool(model_path, 2);
+        ASSERT_EQ(pool.init(), 0);
+        bool first = true;
+        pool.for_each_model([&first](RkPt *model)
+                            {
+                                model->set_rga_preprocess(false);
+                                if (first)
+                                    model->enable_zero_copy_input();
+                                first = false;
+                            });
+        pool.set_pipeline(0, [&](DetectResultsGroup &result)
+                          {
+                              std::lock_guard<std::mutex> lock(mtx);
+                              ids.push_back(result.cur_frame_id);
+                          });
+        for (int id = 0; id < frames; id++)
+            ASSERT_EQ(pool.put(test_frame(id), id), 0);
+    }
+    ASSERT_EQ((int)ids.size(), frames);
+    for (int id = 0; id < frames; id++)
+        EXPECT_EQ(ids[id], id);
+    fake_rknn::FakeLog log = fake_rknn::log();
+    std::sort(log.run_inputs.begin(), log.run_inputs.end());
+    EXPECT_EQ(log.run_inputs, frame_values(0, frames));
+    EXPECT_TRUE(log.violations.empty()) << log.violations[0];
+    EXPECT_EQ(log.live_mems, 0);
+}
+
+// 模型池不轮询NPU：帧在前一帧推理期间或上下文空闲时到达，每帧都只调用一次阻塞的rknn_wait，没有超时返回
+TEST_F(RkPtAsync, PoolWaitsOncePerFrame)
+{
+    const int frames = 12;
+    fake_rknn::FakeConfig config = fake_rknn::default_config();
+    config.run_ms = 20;
+    SetUpRuntime(config);
+    std::vector<int> ids;
+    std::mutex mtx;
+    {
+        RkPtPool pool(model_path, 1);
+        ASSERT_EQ(pool.init(), 0);
+        pool.for_each_model([](RkPt *model) { model->set_rga_preprocess(false); });
+        pool.set_pipeline(0, [&](DetectResultsGroup &result)
+                          {
+                              std::lock_guard<std::mutex> lock(mtx);
+                              ids.push_back(result.cur_frame_id);
+                          });
+        for (int id = 0; id < frames; id++)
+        {
+            ASSERT_EQ(pool.put(test_frame(id), id), 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(id % 2 == 0 ? 10 : 35));
+        }
+    }
+    ASSERT_EQ((int)ids.size(), frames);
+    for (int id = 0; id < frames; id++)
+        EXPECT_EQ(ids[id], id);
+    fake_rknn::FakeLog log = fake_rknn::log();
+    EXPECT_EQ(log.waits, frames);
+    EXPECT_EQ(log.wait_timeouts, 0);
+    EXPECT_TRUE(log.violations.empty()) << log.violations[0];
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+
+#include "common.h"
+#include "det/tensor_memory.h"
+
+// 输入内存和帧句柄测试：主机内存实现的尺寸和视图，以及帧数据在回调、推理、结果之间共享而不复制
+
+// 主机内存：按宽×高×通道分配，不可绑定，模型输入槽的图像视图直接写入这块内存
+TEST(TensorMemory, HostMemoryLayout)
+{
+    const int width = 640, height = 384, channel = 3;
+    HostTensorMemory mem(width, height, channel);
+    ASSERT_NE(mem.data(), nullptr);
+    EXPECT_EQ(mem.size(), (uint32_t)(width * height * channel));
+    EXPECT_EQ(mem.row_stride(), width * channel);
+    EXPECT_EQ(mem.fd(), -1);
+    EXPECT_EQ(mem.offset(), 0);
+    EXPECT_FALSE(mem.bound());
+    EXPECT_EQ(mem.bind(), 0);
+
+    // 与RkPt::set_input_memory相同的视图：写入视图的区域即写入内存
+    cv::Mat img(height, width, CV_8UC3, mem.data(), mem.row_stride());
+    img.setTo(cv::Scalar(128, 128, 128));
+    img(cv::Rect(10, 20, 4, 2)).setTo(cv::Scalar(1, 2, 3));
+    const uint8_t *p = (const uint8_t *)mem.data();
+    EXPECT_EQ(p[0], 128);
+    EXPECT_EQ(p[mem.size() - 1], 128);
+    const uint8_t *q = p + 20 * mem.row_stride() + 10 * channel;
+    EXPECT_EQ(q[0], 1);
+    EXPECT_EQ(q[1], 2);
+    EXPECT_EQ(q[2], 3);
+    EXPECT_EQ(q[-1], 128);
+}
+
+// 通过TensorMemory接口释放时调用实现的析构函数（RkPt按接口持有输入内存）
+TEST(TensorMemory, DeleteThroughInterface)
+{
+    TensorMemory *mem = new HostTensorMemory(32, 32, 3);
+    memset(mem->data(), 0, mem->size());
+    delete mem;
+}
+
+// 帧句柄：图像是所有者数据的视图，所有者随最后一个句柄（包括检测结果中的）释放
+TEST(Frame, OwnerLivesAsLongAsLastHandle)
+{
+    bool released = false;
+    std::shared_ptr<std::vector<uint8_t>> pixels(new std::vector<uint8_t>(64 * 48 * 3, 7),
+                                                 [&released](std::vector<uint8_t> *v)
+                                                 {
+                                                     released = true;
+                                                     delete v;
+                                                 });
+    const uint8_t *data = pixels->data();
+    FramePtr frame = make_frame(cv::Mat(48, 64, CV_8UC3, pixels->data()), pixels);
+    pixels.reset();
+    EXPECT_FALSE(released);
+    EXPECT_EQ(frame->img.data, data);
+
+    // 结果组与输入共享同一份数据，复制结果组不复制图像
+    DetectResultsGroup result;
+    result.cur_frame = frame;
+    result.cur_frame_id = 3;
+    DetectResultsGroup copy = result;
+    EXPECT_EQ(copy.cur_frame->img.data, data);
+
+    frame.reset();
+    result.cur_frame.reset();
+    EXPECT_FALSE(released);
+    copy.cur_frame.reset();
+    EXPECT_TRUE(released);
+}
+
+// 不指定所有者时由图像自身的引用计数持有数据
+TEST(Frame, ImageRefcountWithoutOwner)
+{
+    FramePtr frame;
+    const uint8_t *data;
+    {
+        cv::Mat img(8, 8, CV_8UC3, cv::Scalar(9, 9, 9));
+        data = img.data;
+        frame = make_frame(img);
+    }
+    EXPECT_EQ(frame->img.data, data);
+    EXPECT_EQ(frame->img.at<cv::Vec3b>(7, 7)[0], 9);
+    EXPECT_EQ(frame->owner, nullptr);
+}